@@ -0,0 +1,192 @@
+#include "alphabeta.h"
+#include "evaluation.h"
+#include <limits>
+
+AlphaBetaSearch::AlphaBetaSearch(
+    AstraDoBoard board,
+    const SearchBudget& budget,
+    size_t tt_size
+    ) : rootBoard(board),
+    budget(budget),
+    table(tt_size){
+    for(std::array<uint8_t, 2>& killer : killers) killer.fill(AstraDoGeometry::NO_MOVE);
+    for(std::array<int, AstraDoGeometry::CELLS>& side : history) side.fill(0);
+}
+
+int AlphaBetaSearch::terminalScore(const AstraDoBoard& board){
+    std::pair<int, int> piece_count = board.getPieceCount();
+    int diff = board.getTurn() ? piece_count.first - piece_count.second : piece_count.second - piece_count.first;
+    if(diff > 0) return SCORE_WIN + diff * 100;
+    if(diff < 0) return -SCORE_WIN + diff * 100;
+    return 0;
+}
+
+int AlphaBetaSearch::evaluate(const AstraDoBoard& board){
+    std::pair<int, int> stable_count = board.getStableCount();
+    int own_stable = board.getTurn() ? stable_count.first : stable_count.second;
+    int oppo_stable = board.getTurn() ? stable_count.second : stable_count.first;
+
+    // More than half of the board is stable, the winner is already known
+    // Stable pieces bound the final piece count of both sides
+    if(own_stable > AstraDoGeometry::CELLS / 2) return SCORE_WIN + (2 * own_stable - AstraDoGeometry::CELLS) * 100;
+    if(oppo_stable > AstraDoGeometry::CELLS / 2) return -SCORE_WIN + (AstraDoGeometry::CELLS - 2 * oppo_stable) * 100;
+
+    // Evaluation stays well below the scores of finished games
+    int score = AstraDoEvaluator::evaluate(board, stable_count);
+    return std::max(-SCORE_WIN / 2, std::min(SCORE_WIN / 2, score));
+}
+
+void AlphaBetaSearch::checkLimits(){
+    if(stopFlag && stopFlag->load(std::memory_order_relaxed)){
+        aborted = true;
+    }
+    else if(budget.nodes > 0 && nodes >= budget.nodes){
+        aborted = true;
+    }
+    else if(budget.timeMs > 0 &&
+             std::chrono::steady_clock::now() - startTime >= std::chrono::milliseconds(budget.timeMs)){
+        aborted = true;
+    }
+}
+
+void AlphaBetaSearch::orderMoves(std::vector<uint8_t>& moves, uint8_t tt_move, int ply, bool turn) const {
+    std::vector<std::pair<int, uint8_t>> scored;
+    scored.reserve(moves.size());
+    for(uint8_t move : moves){
+        int score;
+        if(move == tt_move) score = std::numeric_limits<int>::max();
+        else if(move == killers[ply][0]) score = std::numeric_limits<int>::max() - 1;
+        else if(move == killers[ply][1]) score = std::numeric_limits<int>::max() - 2;
+        else score = history[turn ? 0 : 1][move];
+        scored.emplace_back(score, move);
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const std::pair<int, uint8_t>& a, const std::pair<int, uint8_t>& b) {
+        return a.first > b.first;
+    });
+    for(size_t i = 0; i < moves.size(); ++i) moves[i] = scored[i].second;
+}
+
+int AlphaBetaSearch::pvs(const AstraDoBoard& board, int depth, int ply, int alpha, int beta){
+    ++nodes;
+    if((nodes & 1023) == 0) checkLimits();
+    if(aborted) return 0;
+
+    // No legal moves can be made + previous move is stale
+    if(board.getMoves().empty() && board.getStale()) return terminalScore(board);
+
+    if(depth <= 0 || ply >= MAX_PLY){
+        hitHorizon = true;
+        return evaluate(board);
+    }
+
+    // Probe transposition table
+    uint64_t key = board.getHash();
+    TTEntry& entry = table[key & (table.size() - 1)];
+    uint8_t tt_move = AstraDoGeometry::NO_MOVE;
+    if(entry.key == key){
+        tt_move = entry.move;
+        if(ply > 0 && entry.depth >= depth){
+            // Stored score may come from a static evaluation
+            hitHorizon = true;
+            if(entry.flag == TT_EXACT) return entry.score;
+            if(entry.flag == TT_LOWER && entry.score >= beta) return entry.score;
+            if(entry.flag == TT_UPPER && entry.score <= alpha) return entry.score;
+        }
+    }
+
+    // Side to move has to pass
+    if(board.getMoves().empty()){
+        AstraDoBoard next(board);
+        next.makeMove(AstraDoGeometry::PASS);
+        return -pvs(next, depth - 1, ply + 1, -beta, -alpha);
+    }
+
+    std::vector<uint8_t> moves(board.getMoves());
+    orderMoves(moves, tt_move, ply, board.getTurn());
+
+    int original_alpha = alpha;
+    int best_score = -SCORE_INF;
+    uint8_t best_move = moves[0];
+    for(size_t i = 0; i < moves.size(); ++i){
+        AstraDoBoard next(board);
+        next.makeMove(moves[i]);
+        int score;
+        // Full window for the first move, null window for the rest
+        if(i == 0){
+            score = -pvs(next, depth - 1, ply + 1, -beta, -alpha);
+        }
+        else{
+            score = -pvs(next, depth - 1, ply + 1, -alpha - 1, -alpha);
+            if(score > alpha && score < beta){
+                score = -pvs(next, depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        if(aborted) return 0;
+
+        if(score > best_score){
+            best_score = score;
+            best_move = moves[i];
+            if(ply == 0) rootBestMove = moves[i];
+        }
+        if(score > alpha) alpha = score;
+        if(alpha >= beta){
+            // Remember quiet refutations for move ordering
+            if(killers[ply][0] != moves[i]){
+                killers[ply][1] = killers[ply][0];
+                killers[ply][0] = moves[i];
+            }
+            history[board.getTurn() ? 0 : 1][moves[i]] += depth * depth;
+            break;
+        }
+    }
+
+    // Store result in transposition table
+    entry.key = key;
+    entry.score = best_score;
+    entry.depth = static_cast<int8_t>(depth);
+    entry.move = best_move;
+    if(best_score <= original_alpha) entry.flag = TT_UPPER;
+    else if(best_score >= beta) entry.flag = TT_LOWER;
+    else entry.flag = TT_EXACT;
+
+    return best_score;
+}
+
+uint8_t AlphaBetaSearch::getBestMove(){
+    if(rootBoard.getMoves().empty()) return AstraDoGeometry::PASS;
+    else if(rootBoard.getMoves().size() == 1) return rootBoard.getMoves()[0];
+
+    startTime = std::chrono::steady_clock::now();
+    nodes = 0;
+    aborted = false;
+    completedDepth = 0;
+    uint8_t best_move = rootBoard.getMoves()[0];
+    int max_depth = budget.depth > 0 ? std::min(budget.depth, MAX_PLY) : MAX_PLY;
+    // Every ply fills a square or passes, and two passes end the game
+    std::pair<int, int> piece_count = rootBoard.getPieceCount();
+    max_depth = std::min(max_depth, 2 * (AstraDoGeometry::CELLS - piece_count.first - piece_count.second) + 1);
+
+    for(int depth = 1; depth <= max_depth; ++depth){
+        rootBestMove = AstraDoGeometry::NO_MOVE;
+        hitHorizon = false;
+        int score = pvs(rootBoard, depth, 0, -SCORE_INF, SCORE_INF);
+
+        // Root moves found before running out of budget are still better than the last iteration
+        if(rootBestMove < AstraDoGeometry::CELLS) best_move = rootBestMove;
+        if(aborted) break;
+
+        bestScore = score;
+        completedDepth = depth;
+        // Every line reached the end of the game, the score is exact
+        if(!hitHorizon) break;
+    }
+    return best_move;
+}
+
+long long AlphaBetaSearch::getNodeCount() const { return nodes; }
+
+void AlphaBetaSearch::setStopFlag(const std::atomic<bool>* flag) { stopFlag = flag; }
+
+int AlphaBetaSearch::getScore() const { return bestScore; }
+
+int AlphaBetaSearch::getDepth() const { return completedDepth; }
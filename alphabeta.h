@@ -0,0 +1,88 @@
+#ifndef ALPHABETA_H
+#define ALPHABETA_H
+
+#include "board.h"
+#include "search.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Iterative-deepening principal variation search
+class AlphaBetaSearch : public SearchEngine {
+private:
+    // Transposition table entry
+    struct TTEntry {
+        uint64_t key = 0;
+        int32_t score = 0;
+        int8_t depth = -1;
+        uint8_t flag = 0;
+        uint8_t move = AstraDoGeometry::NO_MOVE;
+    };
+
+    enum TTFlag : uint8_t { TT_EXACT, TT_LOWER, TT_UPPER };
+
+    AstraDoBoard rootBoard;
+    SearchBudget budget;
+
+    std::vector<TTEntry> table;
+    // Two killer moves for every ply
+    std::array<std::array<uint8_t, 2>, 64> killers;
+    // History scores for each side and square
+    std::array<std::array<int, AstraDoGeometry::CELLS>, 2> history;
+
+    long long nodes = 0;
+    bool aborted = false;
+    // Search ends as soon as the flag is set, it may be set from another thread
+    const std::atomic<bool>* stopFlag = nullptr;
+    // Whether the last iteration reached a static evaluation
+    bool hitHorizon = false;
+    std::chrono::steady_clock::time_point startTime;
+
+    uint8_t rootBestMove = AstraDoGeometry::NO_MOVE;
+    int bestScore = 0;
+    int completedDepth = 0;
+
+    // Default number of transposition table entries (power of 2)
+    static const size_t DEFAULT_TT_SIZE = 1 << 18;
+
+    // Maximum depth of a search, enough to reach the end of every game
+    static const int MAX_PLY = 64;
+
+    int pvs(const AstraDoBoard& board, int depth, int ply, int alpha, int beta);
+
+    // Order moves by transposition table move, killers and history
+    void orderMoves(std::vector<uint8_t>& moves, uint8_t tt_move, int ply, bool turn) const;
+
+    void checkLimits();
+
+public:
+    // Scores are given from the side to move, 100 per piece
+    static const int SCORE_WIN = 20000;
+    static const int SCORE_INF = 32000;
+
+    explicit AlphaBetaSearch(
+        AstraDoBoard board,
+        const SearchBudget& budget = SearchBudget(),
+        size_t tt_size = DEFAULT_TT_SIZE
+        );
+
+    uint8_t getBestMove() override;
+
+    long long getNodeCount() const override;
+
+    void setStopFlag(const std::atomic<bool>* flag) override;
+
+    // Score and depth of the last completed iteration
+    int getScore() const;
+
+    int getDepth() const;
+
+    // Static evaluation of a position from the side to move
+    static int evaluate(const AstraDoBoard& board);
+
+    // Exact score of a finished game from the side to move
+    static int terminalScore(const AstraDoBoard& board);
+};
+
+#endif // ALPHABETA_H
@@ -0,0 +1,17 @@
+#include "analysis.h"
+
+void AnalysisChannel::publish(const AnalysisSnapshot& snapshot){
+    slots[writeSlot] = snapshot;
+    slots[writeSlot].sequence = ++published;
+    // Release makes the slot contents visible to the reader that picks it up
+    uint8_t previous = shared.exchange(writeSlot | FRESH, std::memory_order_acq_rel);
+    writeSlot = previous & ~FRESH;
+}
+
+bool AnalysisChannel::read(AnalysisSnapshot& snapshot){
+    if(!(shared.load(std::memory_order_relaxed) & FRESH)) return false;
+    uint8_t previous = shared.exchange(readSlot, std::memory_order_acq_rel);
+    readSlot = previous & ~FRESH;
+    snapshot = slots[readSlot];
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "geometry.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Root moves and principal variation plies kept in a snapshot
+const int ANALYSIS_MAX_LINES = 8;
+const int ANALYSIS_MAX_PV = 16;
+
+// Game-theoretic value of a node once it has been proven
+enum class ProvenResult { Unknown, BlackWin, WhiteWin, Draw };
+
+// Statistics of one root move, from the side to move at the root
+struct AnalysisLine {
+    uint8_t move = AstraDoGeometry::NO_MOVE;
+    int visits = 0;
+    // Expected result from 0 (loss) to 1 (win), proven results count fully
+    double winRate = 0.5;
+    // Average final piece difference, own pieces minus the opponent's
+    double scoreDiff = 0;
+    ProvenResult proven = ProvenResult::Unknown;
+    // Most visited line starting with the move, PASS of the geometry for a pass
+    int pvLength = 0;
+    std::array<uint8_t, ANALYSIS_MAX_PV> pv{};
+};
+
+// Top root moves of a search at one moment, best first
+struct AnalysisSnapshot {
+    // Increases with every published snapshot, 0 if none has been published yet
+    uint64_t sequence = 0;
+    long long iterations = 0;
+    int timeMs = 0;
+    long long treeNodes = 0;
+    int lineCount = 0;
+    std::array<AnalysisLine, ANALYSIS_MAX_LINES> lines;
+};
+
+// Hands snapshots from the searching thread to one reader thread without locks
+// Triple buffer: the writer and the reader each own a slot and swap it with the shared one,
+// so neither ever waits for the other and the reader always gets the latest complete snapshot
+class AnalysisChannel {
+private:
+    std::array<AnalysisSnapshot, 3> slots;
+    // Index of the shared slot, FRESH is set when it holds a snapshot the reader has not seen
+    std::atomic<uint8_t> shared{0};
+    static const uint8_t FRESH = 4;
+    // Only touched by the writer and by the reader respectively
+    uint8_t writeSlot = 1;
+    uint8_t readSlot = 2;
+    uint64_t published = 0;
+
+public:
+    // Writer side, called by the search
+    void publish(const AnalysisSnapshot& snapshot);
+
+    // Reader side, copies the latest snapshot
+    // Returns false and leaves the snapshot unchanged if nothing new was published
+    bool read(AnalysisSnapshot& snapshot);
+};
+
+#endif // ANALYSIS_H
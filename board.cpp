@@ -1,103 +1,308 @@
 #include "board.h"
+#include <random>
 
 // Board Representation of AstraDo, Version 1
 
+namespace {
+
+// Zobrist keys for pieces of both sides, the side to move and the stale flag
+template<int CELLS>
+struct ZobristKeys {
+    std::array<std::array<uint64_t, CELLS>, 2> pieces;
+    uint64_t turn;
+    uint64_t stale;
+
+    ZobristKeys(){
+        // Fixed seed so that hashes are reproducible between runs
+        std::mt19937_64 rng(0x41535452414444ULL);
+        for(std::array<uint64_t, CELLS>& side : pieces){
+            for(uint64_t& key : side) key = rng();
+        }
+        turn = rng();
+        stale = rng();
+    }
+};
+
+template<int CELLS>
+const ZobristKeys<CELLS>& zobrist(){
+    static const ZobristKeys<CELLS> keys;
+    return keys;
+}
+
+}
+
 // Initialize board with default setup
-AstraDoBoard::AstraDoBoard(){
-    // Pos 0, 18, 36 are initially occupied by the side to play first (black)
-    black_pieces.fill(false);
-    black_pieces[0] = true;
-    black_pieces[18] = true;
-    black_pieces[36] = true;
-
-    // Pos 9, 27, 45 are initially occupied by the side to play second (white)
-    white_pieces.fill(false);
-    white_pieces[9] = true;
-    white_pieces[27] = true;
-    white_pieces[45] = true;
+template<class Geometry>
+BasicBoard<Geometry>::BasicBoard(){
+    const GeometryTables& tables = Geometry::tables();
+    for(uint8_t pos : tables.blackStart) black_pieces.set(pos);
+    for(uint8_t pos : tables.whiteStart) white_pieces.set(pos);
 
     turn = true;
     stale = false;
     findLegalMoves();
+    refreshAccumulator();
 }
 
 // Initialize with given board condition
-AstraDoBoard::AstraDoBoard(
-    const std::array<bool, 54>& black_array,
-    const std::array<bool, 54>& white_array,
+template<class Geometry>
+BasicBoard<Geometry>::BasicBoard(
+    const Bits& black_bits,
+    const Bits& white_bits,
     bool next_turn
-    ) : black_pieces(black_array),
-    white_pieces(white_array),
+    ) : black_pieces(black_bits),
+    white_pieces(white_bits),
     turn(next_turn)
 {
     stale = false;
     findLegalMoves();
+    refreshAccumulator();
+}
+
+template<class Geometry>
+void BasicBoard<Geometry>::refreshAccumulator(){
+    if constexpr(Geometry::STANDARD){
+        if(const AstraDoNetwork* network = AstraDoNetwork::active()) network->refresh(accumulator.create(), *this);
+    }
 }
 
 // Some getter and setters
-const std::array<bool, 54>& AstraDoBoard::getBlackPieces() const {
+template<class Geometry>
+const typename BasicBoard<Geometry>::Bits& BasicBoard<Geometry>::getBlackPieces() const {
     return black_pieces;
 }
 
-const std::array<bool, 54>& AstraDoBoard::getWhitePieces() const {
+template<class Geometry>
+const typename BasicBoard<Geometry>::Bits& BasicBoard<Geometry>::getWhitePieces() const {
     return white_pieces;
 }
 
-const std::vector<uint8_t>& AstraDoBoard::getMoves() const {
+template<class Geometry>
+const std::vector<uint8_t>& BasicBoard<Geometry>::getMoves() const {
     return moves;
 }
 
-bool AstraDoBoard::getTurn() const {
+template<class Geometry>
+std::vector<typename BasicBoard<Geometry>::Bits> BasicBoard<Geometry>::findFlips() const {
+    std::array<Bits, CELLS> found_flips;
+    scanMoves(&found_flips);
+    std::vector<Bits> flips;
+    flips.reserve(moves.size());
+    for(uint8_t move : moves) flips.push_back(found_flips[move]);
+    return flips;
+}
+
+template<class Geometry>
+bool BasicBoard<Geometry>::getTurn() const {
     return turn;
 }
 
-void AstraDoBoard::switchTurn() {
+template<class Geometry>
+void BasicBoard<Geometry>::switchTurn() {
     turn = !turn;
 }
 
-bool AstraDoBoard::getStale() const {
+template<class Geometry>
+bool BasicBoard<Geometry>::getStale() const {
     return stale;
 }
 
-void AstraDoBoard::setStale(bool stale) {
+template<class Geometry>
+void BasicBoard<Geometry>::setStale(bool stale) {
     this->stale = stale;
 }
 
-std::pair<int, int> AstraDoBoard::getPieceCount() const {
-    int black_count = std::count(black_pieces.begin(), black_pieces.end(), true);
-    int white_count = std::count(white_pieces.begin(), white_pieces.end(), true);
-    return std::make_pair(black_count, white_count);
+template<class Geometry>
+std::pair<int, int> BasicBoard<Geometry>::getPieceCount() const {
+    return std::make_pair(black_pieces.count(), white_pieces.count());
 }
 
-// Find all legal moves in the current position
-void AstraDoBoard::findLegalMoves() {
-    std::set<uint8_t> moves_set;
-    size_t cur_pointer = 0, cur_pos, cur_move;
+template<class Geometry>
+const typename BasicBoard<Geometry>::Accumulator& BasicBoard<Geometry>::getAccumulator() const {
+    return accumulator;
+}
+
+template<class Geometry>
+std::string BasicBoard<Geometry>::toString() const {
+    std::string text(CELLS, '.');
+    for(int i = 0; i < CELLS; ++i){
+        if(black_pieces[i]) text[i] = 'b';
+        else if(white_pieces[i]) text[i] = 'w';
+    }
+    text += turn ? " b " : " w ";
+    text += stale ? '1' : '0';
+    return text;
+}
+
+template<class Geometry>
+std::string BasicBoard<Geometry>::moveToString(uint8_t move){
+    return move >= CELLS ? "pass" : std::to_string(move);
+}
+
+template<class Geometry>
+bool BasicBoard<Geometry>::fromString(const std::string& text, BasicBoard& board){
+    if(text.size() < CELLS + 2 || text[CELLS] != ' ') return false;
+    Bits black_bits, white_bits;
+    for(int i = 0; i < CELLS; ++i){
+        if(text[i] == 'b') black_bits.set(i);
+        else if(text[i] == 'w') white_bits.set(i);
+        else if(text[i] != '.') return false;
+    }
+    bool next_turn;
+    if(text[CELLS + 1] == 'b') next_turn = true;
+    else if(text[CELLS + 1] == 'w') next_turn = false;
+    else return false;
+    // Stale flag is optional and defaults to 0
+    bool next_stale = false;
+    if(text.size() > CELLS + 2){
+        if(text.size() != CELLS + 4 || text[CELLS + 2] != ' ' || (text[CELLS + 3] != '0' && text[CELLS + 3] != '1')) return false;
+        next_stale = text[CELLS + 3] == '1';
+    }
+    board = BasicBoard(black_bits, white_bits, next_turn);
+    board.setStale(next_stale);
+    return true;
+}
+
+template<class Geometry>
+uint64_t BasicBoard<Geometry>::getHash() const {
+    const ZobristKeys<CELLS>& keys = zobrist<CELLS>();
+    uint64_t key = 0;
+    black_pieces.forEach([&](int pos) { key ^= keys.pieces[0][pos]; });
+    white_pieces.forEach([&](int pos) { key ^= keys.pieces[1][pos]; });
+    if(turn) key ^= keys.turn;
+    if(stale) key ^= keys.stale;
+    return key;
+}
+
+// A piece is flipped only by a move on one of its three lines that brackets it
+// It is safe on a line if the line is full, or if it is next to the edge
+// or to a stable piece of its own colour on that line
+template<class Geometry>
+std::pair<typename BasicBoard<Geometry>::Bits, typename BasicBoard<Geometry>::Bits> BasicBoard<Geometry>::getStablePieces() const {
+    const GeometryTables& tables = Geometry::tables();
+    // Line id and neighbors of every square on its three lines, NO_MOVE for the edge
+    static const std::array<std::array<std::array<uint8_t, 3>, 3>, CELLS> neighbors = [&tables](){
+        std::array<std::array<std::array<uint8_t, 3>, 3>, CELLS> table;
+        for(int pos = 0; pos < CELLS; ++pos){
+            for(size_t i = 0; i < 3; ++i){
+                uint8_t line_id = tables.squares[pos][i][0];
+                size_t line_pointer = tables.squares[pos][i][1];
+                const std::vector<uint8_t>& line = tables.lines[line_id];
+                table[pos][i][0] = line_id;
+                table[pos][i][1] = line_pointer == 0 ? NO_MOVE : line[line_pointer - 1];
+                table[pos][i][2] = line_pointer + 1 == line.size() ? NO_MOVE : line[line_pointer + 1];
+            }
+        }
+        return table;
+    }();
+
+    Bits stable;
+    Bits occupied = black_pieces | white_pieces;
+
+    // Lines without empty squares can never be played on again
+    std::array<bool, Geometry::LINES> full_line{false};
+    for(size_t i = 0; i < tables.lines.size(); ++i){
+        full_line[i] = std::all_of(tables.lines[i].begin(), tables.lines[i].end(), [&occupied](uint8_t pos) {
+            return occupied[pos];
+        });
+    }
+
+    // Grow the stable set until nothing changes
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(int pos = 0; pos < CELLS; ++pos){
+            if(stable[pos] || !occupied[pos]) continue;
+            const Bits& own_pieces = black_pieces[pos] ? black_pieces : white_pieces;
+
+            bool safe = true;
+            for(const std::array<uint8_t, 3>& neighbor : neighbors[pos]){
+                if(full_line[neighbor[0]]) continue;
+                // Edge of the line, or a stable piece of the same colour next to it
+                uint8_t left = neighbor[1];
+                uint8_t right = neighbor[2];
+                if(left >= CELLS || right >= CELLS) continue;
+                if((stable[left] && own_pieces[left]) || (stable[right] && own_pieces[right])) continue;
+                safe = false;
+                break;
+            }
+            if(safe){
+                stable.set(pos);
+                changed = true;
+            }
+        }
+    }
+
+    return std::make_pair(stable & black_pieces, stable & white_pieces);
+}
+
+template<class Geometry>
+std::pair<int, int> BasicBoard<Geometry>::getStableCount() const {
+    std::pair<Bits, Bits> stable_pieces = getStablePieces();
+    return std::make_pair(stable_pieces.first.count(), stable_pieces.second.count());
+}
+
+// Every line is scanned from both ends; a move is an empty square followed by opponent pieces and an own piece
+template<class Geometry>
+typename BasicBoard<Geometry>::Bits BasicBoard<Geometry>::scanMoves(std::array<Bits, CELLS>* found_flips) const {
+    const std::vector<std::vector<uint8_t>>& lines = Geometry::tables().lines;
+    // Squares of the first k cells of every line, the cells between two pointers are the difference of two entries
+    static const std::vector<std::vector<Bits>> line_prefix = [&lines](){
+        std::vector<std::vector<Bits>> table(lines.size());
+        for(size_t i = 0; i < lines.size(); ++i){
+            table[i].resize(lines[i].size() + 1);
+            for(size_t k = 0; k < lines[i].size(); ++k){
+                table[i][k + 1] = table[i][k];
+                table[i][k + 1].set(lines[i][k]);
+            }
+        }
+        return table;
+    }();
+
+    const Bits& own_pieces = turn ? black_pieces : white_pieces;
+    const Bits& oppo_pieces = turn ? white_pieces : black_pieces;
+    // Moves found on several lines are only kept once, and come out in increasing order
+    Bits moves_set;
+    size_t cur_pointer = 0, cur_pos, cur_move, move_pointer = 0;
     bool own_piece, oppo_piece, capture_piece;
+    // Whether cur_move is a move on this line
+    // The original scan dropped a square whose bracket was broken by an empty square and only started again
+    // at the next empty square, so the breaking square was never a move on that line. The breaking square
+    // is followed here anyway, uncounted, because it may be a move through another line and then flips
+    // this bracket too. The empty square that breaks an uncounted bracket is where the original scan
+    // started again, so it is counted. Both scan directions follow the same rule.
+    bool counted = false;
     for (size_t i = 0; i < lines.size(); ++i) {
-        cur_pointer = 0;
-        cur_move = 100;     // 100 indicates invalid move
-        capture_piece = false;  // Indicate whether there exists opponent piece that can be captured
+        const std::vector<uint8_t>& line = lines[i];
+        // Squares of the first k cells of the line
+        const std::vector<Bits>& prefix = line_prefix[i];
 
         // Search from front
-        while(cur_pointer < lines[i].size()){
-            cur_pos = lines[i][cur_pointer];
-            own_piece = turn ? black_pieces[cur_pos] : white_pieces[cur_pos];
-            oppo_piece = turn ? white_pieces[cur_pos] : black_pieces[cur_pos];
+        cur_pointer = 0;
+        cur_move = NO_MOVE;
+        capture_piece = false;
+        while(cur_pointer < line.size()){
+            cur_pos = line[cur_pointer];
+            own_piece = own_pieces[cur_pos];
+            oppo_piece = oppo_pieces[cur_pos];
 
             // If found an unoccupied square in front
-            if(cur_move < 54){
+            if(cur_move < CELLS){
                 // If already found pieces that can be captured
                 if(capture_piece){
-                    // Current square is own piece, output move
+                    // Current square is own piece, record the squares in between and output move
                     if(own_piece){
-                        moves_set.insert(cur_move);
-                        cur_move = 100;
+                        if(found_flips) (*found_flips)[cur_move] |= prefix[cur_pointer] ^ prefix[move_pointer + 1];
+                        if(counted) moves_set.set(cur_move);
+                        cur_move = NO_MOVE;
                         capture_piece = false;
                     }
-                    // Current square is unoccupied, move is invalid
+                    // Current square is unoccupied, the bracket is broken
+                    // The square is a move on this line only if the broken bracket was uncounted, see counted
                     else if(!oppo_piece){
-                        cur_move = 100;
+                        cur_move = cur_pos;
+                        move_pointer = cur_pointer;
+                        counted = !counted;
                         capture_piece = false;
                     }
                     // Current square is still opponent piece, continue
@@ -111,11 +316,13 @@ void AstraDoBoard::findLegalMoves() {
                     // Current square is our own piece
                     // Cannot make move on this square, search next
                     else if(own_piece) {
-                        cur_move = 100;
+                        cur_move = NO_MOVE;
                     }
                     // Current square is unoccupied, update move
                     else{
                         cur_move = cur_pos;
+                        move_pointer = cur_pointer;
+                        counted = true;
                     }
                 }
             }
@@ -125,6 +332,8 @@ void AstraDoBoard::findLegalMoves() {
                 // Save the position of square for examination
                 if(!own_piece && !oppo_piece){
                     cur_move = cur_pos;
+                    move_pointer = cur_pointer;
+                    counted = true;
                 }
                 // If current square is occupied, skip
             }
@@ -132,34 +341,32 @@ void AstraDoBoard::findLegalMoves() {
         }
 
         // Search from back
-        cur_pointer = lines[i].size() - 1;
-        cur_move = 100;
+        cur_pointer = line.size() - 1;
+        cur_move = NO_MOVE;
         capture_piece = false;
-        // Since cur_pointer is uint8_t, it will overflow to 255 after 0
-        while(cur_pointer < lines[i].size()){
-            cur_pos = lines[i][cur_pointer];
-            if(turn){
-                own_piece = black_pieces[cur_pos];
-                oppo_piece = white_pieces[cur_pos];
-            }
-            else{
-                own_piece = white_pieces[cur_pos];
-                oppo_piece = black_pieces[cur_pos];
-            }
+        // Since cur_pointer is unsigned, it will overflow past the end of the line after 0
+        while(cur_pointer < line.size()){
+            cur_pos = line[cur_pointer];
+            own_piece = own_pieces[cur_pos];
+            oppo_piece = oppo_pieces[cur_pos];
 
             // If found an unoccupied square in front
-            if(cur_move < 54){
+            if(cur_move < CELLS){
                 // If already found pieces that can be captured
                 if(capture_piece){
-                    // Current square is own piece, output move
+                    // Current square is own piece, record the squares in between and output move
                     if(own_piece){
-                        moves_set.insert(cur_move);
-                        cur_move = 100;
+                        if(found_flips) (*found_flips)[cur_move] |= prefix[move_pointer] ^ prefix[cur_pointer + 1];
+                        if(counted) moves_set.set(cur_move);
+                        cur_move = NO_MOVE;
                         capture_piece = false;
                     }
-                    // Current square is unoccupied, move is invalid
+                    // Current square is unoccupied, the bracket is broken
+                    // The square is a move on this line only if the broken bracket was uncounted, see counted
                     else if(!oppo_piece){
-                        cur_move = 100;
+                        cur_move = cur_pos;
+                        move_pointer = cur_pointer;
+                        counted = !counted;
                         capture_piece = false;
                     }
                     // Current square is still opponent piece, continue
@@ -173,11 +380,13 @@ void AstraDoBoard::findLegalMoves() {
                     // Current square is our own piece
                     // Cannot make move on this square, search next
                     else if(own_piece) {
-                        cur_move = 100;
+                        cur_move = NO_MOVE;
                     }
                     // Current square is unoccupied, update move
                     else{
                         cur_move = cur_pos;
+                        move_pointer = cur_pointer;
+                        counted = true;
                     }
                 }
             }
@@ -187,6 +396,8 @@ void AstraDoBoard::findLegalMoves() {
                 // Save the position of square for examination
                 if(!own_piece && !oppo_piece){
                     cur_move = cur_pos;
+                    move_pointer = cur_pointer;
+                    counted = true;
                 }
                 // If current square is occupied, skip
             }
@@ -194,16 +405,62 @@ void AstraDoBoard::findLegalMoves() {
         }
     }
 
-    // Copy content to "moves"
-    moves.assign(moves_set.begin(), moves_set.end());
+    return moves_set;
+}
+
+// Find all legal moves in the current position
+template<class Geometry>
+void BasicBoard<Geometry>::findLegalMoves() {
+    Bits moves_set = scanMoves(nullptr);
+    // Copy content to "moves", at most one allocation when the position has more moves than the storage holds
+    moves.clear();
+    moves.reserve(moves_set.count());
+    moves_set.forEach([this](int pos) { moves.push_back(static_cast<uint8_t>(pos)); });
+}
+
+// Squares flipped by a move, found by walking its lines
+template<class Geometry>
+typename BasicBoard<Geometry>::Bits BasicBoard<Geometry>::walkFlips(uint8_t move) const {
+    const GeometryTables& tables = Geometry::tables();
+    const Bits& current_pieces = turn ? black_pieces : white_pieces;
+    const Bits& opponent_pieces = turn ? white_pieces : black_pieces;
+    Bits square_set;
+    for(const std::array<uint8_t, 2>& square : tables.squares[move]){
+        const std::vector<uint8_t>& line = tables.lines[square[0]];
+        for(int step : {1, -1}){
+            Bits captured;
+            for(int cur_pointer = square[1] + step; cur_pointer >= 0 && cur_pointer < static_cast<int>(line.size()); cur_pointer += step){
+                uint8_t cur_pos = line[cur_pointer];
+                // Neighboring square is occupied by opponent, continue search
+                if(opponent_pieces[cur_pos]){
+                    captured.set(cur_pos);
+                    continue;
+                }
+                // Has own pieces next to opponent pieces, make capture
+                if(current_pieces[cur_pos]) square_set |= captured;
+                break;
+            }
+        }
+    }
+    return square_set;
 }
 
 // Note that this function does not check whether the move is legal
 // The check should be performed by caller before calling this method
-// If move >= 54 (illegal move), the function will simply flip the side of the board
-void AstraDoBoard::makeMove(uint8_t move) {
+// If move >= CELLS (illegal move), the function will simply flip the side of the board
+template<class Geometry>
+void BasicBoard<Geometry>::makeMove(uint8_t move) {
+    if(move >= CELLS){
+        makeMove(move, Bits());
+        return;
+    }
+    makeMove(move, walkFlips(move));
+}
+
+template<class Geometry>
+void BasicBoard<Geometry>::makeMove(uint8_t move, Bits flipped) {
     // No legal moves can be made
-    if(move >= 54){
+    if(move >= CELLS){
         // Set stale condition
         stale = true;
 
@@ -214,98 +471,51 @@ void AstraDoBoard::makeMove(uint8_t move) {
         findLegalMoves();
         return;
     }
-    uint8_t line_id, line_pointer, cur_pointer, cur_pos;
-    bool capture = false;
-    std::array<bool, 54>& current_pieces = turn ? black_pieces : white_pieces;
-    std::array<bool, 54>& opponent_pieces = turn ? white_pieces : black_pieces;
-    // Set status on the square of the move
-    current_pieces[move] = true;
-    std::set<uint8_t> square_set;
-
-    for (size_t i = 0; i < squares[move].size(); ++i){
-        line_id = squares[move][i][0];
-        line_pointer = squares[move][i][1];
-
-        // Search in right-hand side
-        capture = false;
-        cur_pointer = line_pointer + 1;
-        while(cur_pointer < lines[line_id].size()){
-            cur_pos = lines[line_id][cur_pointer];
-            // Has neighboring pieces that can be captured
-            if(capture){
-                // Has own pieces next to opponent pieces, make capture
-                if(current_pieces[cur_pos]){
-                    // Record all squares that should be flipped
-                    --cur_pointer;
-                    while(cur_pointer > line_pointer){
-                        cur_pos = lines[line_id][cur_pointer];
-                        square_set.insert(cur_pos);
-                        --cur_pointer;
-                    }
-                    break;
-                }
-                // Neighboring square is unoccupied, end search
-                else if(!opponent_pieces[cur_pos]){
-                    break;
-                }
-                // Neighboring square is occupied by opponent, continue search
-            }
-            else{
-                // Found neighboring opponent piece, mark as capture
-                if(opponent_pieces[cur_pos]){
-                    capture = true;
-                }
-                // Neighboring piece is our own piece or empty, cannot capture on this direction
-                else{
-                    break;
-                }
-            }
-            ++cur_pointer;
-        }
+    applyMove(move, flipped);
 
-        // Search in left-hand side
-        capture = false;
-        cur_pointer = line_pointer - 1;
-        // Note that cur_pointer has type uint8_t, it will overflow to 255 after 0
-        while(cur_pointer < lines[line_id].size()){
-            cur_pos = lines[line_id][cur_pointer];
-            // Has neighboring pieces that can be captured
-            if(capture){
-                // Has own pieces next to opponent pieces, make capture
-                if(current_pieces[cur_pos]){
-                    // Record all squares that should be flipped
-                    ++cur_pointer;
-                    while(cur_pointer < line_pointer){
-                        cur_pos = lines[line_id][cur_pointer];
-                        square_set.insert(cur_pos);
-                        ++cur_pointer;
-                    }
-                    break;
-                }
-                // Neighboring square is unoccupied, end search
-                else if(!opponent_pieces[cur_pos]){
-                    break;
-                }
-                // Neighboring square is occupied by opponent, continue search
-            }
-            else{
-                // Found neighboring opponent piece, mark as capture
-                if(opponent_pieces[cur_pos]){
-                    capture = true;
-                }
-                // Neighboring piece is our own piece or empty, cannot capture on this direction
-                else{
-                    break;
-                }
-            }
-            --cur_pointer;
-        }
-    }
+    // Update current potential moves
+    findLegalMoves();
+}
+
+template<class Geometry>
+BasicBoard<Geometry> BasicBoard<Geometry>::afterMove(uint8_t move, const Bits& flipped) const {
+    return BasicBoard(*this, move, flipped);
+}
+
+// Only the pieces are taken from the parent, its moves would be replaced right away
+template<class Geometry>
+BasicBoard<Geometry>::BasicBoard(
+    const BasicBoard& parent,
+    uint8_t move,
+    const Bits& flipped
+    ) : black_pieces(parent.black_pieces),
+    white_pieces(parent.white_pieces),
+    turn(parent.turn),
+    stale(parent.stale),
+    accumulator(parent.accumulator)
+{
+    applyMove(move, flipped);
+    findLegalMoves();
+}
 
-    // Flip all the recorded squares
-    for(uint8_t square : square_set){
-        black_pieces[square] = !black_pieces[square];
-        white_pieces[square] = !white_pieces[square];
+template<class Geometry>
+void BasicBoard<Geometry>::applyMove(uint8_t move, const Bits& flipped) {
+    // Set status on the square of the move and flip the bracketed squares
+    (turn ? black_pieces : white_pieces).set(move);
+    black_pieces ^= flipped;
+    white_pieces ^= flipped;
+
+    // Only the placed and flipped squares change the first layer of the network
+    if constexpr(Geometry::STANDARD){
+        const AstraDoNetwork* network = AstraDoNetwork::active();
+        NnueAccumulator* values = accumulator.get();
+        if(network && values && values->generation == network->getGeneration()){
+            network->addPiece(*values, move, turn);
+            flipped.forEach([&](int square) { network->flipPiece(*values, square, turn); });
+        }
+        else if(network){
+            network->refresh(accumulator.create(), *this);
+        }
     }
 
     // Set stale
@@ -313,91 +523,10 @@ void AstraDoBoard::makeMove(uint8_t move) {
 
     // Flip the side of the game
     switchTurn();
-
-    // Update current potential moves
-    findLegalMoves();
 }
 
-const std::vector<std::vector<uint8_t>> AstraDoBoard::lines = {
-    // Horizontal lines
-    {40, 35, 34, 33, 32, 31, 26},
-    {42, 41, 37, 30, 29, 28, 21, 25, 24},
-    {44, 43, 39, 38, 36, 27, 18, 20, 19, 23, 22},
-    {49, 50, 46, 47, 45,  0,  9, 11, 12, 16, 17},
-    {51, 52, 48,  1,  2,  3, 10, 14, 15},
-    {53,  4,  5,  6,  7,  8,  13},
-
-    // Top right to bottom left
-    {35, 40, 41, 42, 43, 44, 49},
-    {33, 34, 30, 37, 38, 39, 46, 50, 51},
-    {31, 32, 28, 29, 27, 36, 45, 47, 48, 52, 53},
-    {26, 25, 21, 20, 18,  9,  0,  2,  1,  5,  4},
-    {24, 23, 19, 12, 11, 10,  3,  7,  6},
-    {22, 17, 16, 15, 14, 13,  8},
-
-    // Top Left to bottom right
-    {31, 26, 25, 24, 23, 22, 17},
-    {33, 32, 28, 21, 20, 19, 12, 16, 15},
-    {35, 34, 30, 29, 27, 18,  9, 11, 10, 14, 13},
-    {40, 41, 37, 38, 36, 45,  0,  2,  3,  7,  8},
-    {42, 43, 39, 46, 47, 48,  1,  5,  6},
-    {44, 49, 50, 51, 52, 53,  4},
-    };
-
-// Stores the id of line and the corresponding position within the line for each square
-const std::vector<std::vector<std::vector<uint8_t>>> AstraDoBoard::squares = {
-    {{3, 5}, {9, 6}, {15, 6}},
-    {{4, 3}, {9, 8}, {16, 6}},
-    {{4, 4}, {9, 7}, {15, 7}},
-    {{4, 5}, {10, 6}, {15, 8}},
-    {{5, 1}, {9, 10}, {17, 6}},
-    {{5, 2}, {9, 9}, {16, 7}},
-    {{5, 3}, {10, 8}, {16, 8}},
-    {{5, 4}, {10, 7}, {15, 9}},
-    {{5, 5}, {11, 6}, {15, 10}},
-    {{3, 6}, {9, 5}, {14, 6}},
-    {{4, 6}, {10, 5}, {14, 8}},
-    {{3, 7}, {10, 4}, {14, 7}},
-    {{3, 8}, {10, 3}, {13, 6}},
-    {{5, 6}, {11, 5}, {14, 10}},
-    {{4, 7}, {11, 4}, {14, 9}},
-    {{4, 8}, {11, 3}, {13, 8}},
-    {{3, 9}, {11, 2}, {13, 7}},
-    {{3, 10}, {11, 1}, {12, 6}},
-    {{2, 6}, {9, 4}, {14, 5}},
-    {{2, 8}, {10, 2}, {13, 5}},
-    {{2, 7}, {9, 3}, {13, 4}},
-    {{1, 6}, {9, 2}, {13, 3}},
-    {{2, 10}, {11, 0}, {12, 5}},
-    {{2, 9}, {10, 1}, {12, 4}},
-    {{1, 8}, {10, 0}, {12, 3}},
-    {{1, 7}, {9, 1}, {12, 2}},
-    {{0, 6}, {9, 0}, {12, 1}},
-    {{2, 5}, {8, 4}, {14, 4}},
-    {{1, 5}, {8, 2}, {13, 2}},
-    {{1, 4}, {8, 3}, {14, 3}},
-    {{1, 3}, {7, 2}, {14, 2}},
-    {{0, 5}, {8, 0}, {12, 0}},
-    {{0, 4}, {8, 1}, {13, 1}},
-    {{0, 3}, {7, 0}, {13, 0}},
-    {{0, 2}, {7, 1}, {14, 1}},
-    {{0, 1}, {6, 0}, {14, 0}},
-    {{2, 4}, {8, 5}, {15, 4}},
-    {{1, 2}, {7, 3}, {15, 2}},
-    {{2, 3}, {7, 4}, {15, 3}},
-    {{2, 2}, {7, 5}, {16, 2}},
-    {{0, 0}, {6, 1}, {15, 0}},
-    {{1, 1}, {6, 2}, {15, 1}},
-    {{1, 0}, {6, 3}, {16, 0}},
-    {{2, 1}, {6, 4}, {16, 1}},
-    {{2, 0}, {6, 5}, {17, 0}},
-    {{3, 4}, {8, 6}, {15, 5}},
-    {{3, 2}, {7, 6}, {16, 3}},
-    {{3, 3}, {8, 7}, {16, 4}},
-    {{4, 2}, {8, 8}, {16, 5}},
-    {{3, 0}, {6, 6}, {17, 1}},
-    {{3, 1}, {7, 7}, {17, 2}},
-    {{4, 0}, {7, 8}, {17, 3}},
-    {{4, 1}, {8, 9}, {17, 4}},
-    {{5, 0}, {8, 10}, {17, 5}}
-};
+template class BasicBoard<AstraDoGeometry>;
+template class BasicBoard<HexGeometry<3>>;
+template class BasicBoard<HexGeometry<4>>;
+template class BasicBoard<HexGeometry<5>>;
+template class BasicBoard<HexGeometry<6>>;
@@ -3,18 +3,35 @@
 
 #include <array>
 #include <vector>
-#include <set>
 #include <utility>
 #include <cstdint>
 #include <iostream>
 #include <algorithm>
+#include <string>
+#include <type_traits>
+#include "geometry.h"
+#include "nnue.h"
+
+// Boards without an evaluation network keep no accumulator
+struct NoAccumulator {};
+
+// Board of any geometry, see geometry.h
+// Pieces are bit sets of (CELLS + 63) / 64 words
+template<class Geometry>
+class BasicBoard{
+public:
+    static constexpr int CELLS = Geometry::CELLS;
+    static constexpr uint8_t PASS = Geometry::PASS;
+    static constexpr uint8_t NO_MOVE = Geometry::NO_MOVE;
+
+    using Bits = BoardBits<(CELLS + 63) / 64>;
+    using Accumulator = typename std::conditional<Geometry::STANDARD, LazyAccumulator, NoAccumulator>::type;
 
-class AstraDoBoard{
 private:
     // Position of pieces of current side (next to play)
-    std::array<bool, 54> black_pieces{false};
+    Bits black_pieces;
     // Position of opponent pieces
-    std::array<bool, 54> white_pieces{false};
+    Bits white_pieces;
     std::vector<uint8_t> moves;
 
     // Current turn of the game
@@ -24,27 +41,47 @@ private:
     // Whether previous move cannot be made
     bool stale;
 
-    static const std::vector<std::vector<uint8_t>> lines;
-    static const std::vector<std::vector<std::vector<uint8_t>>> squares;
+    // First layer of the evaluation network, allocated and then updated by every move while a network is loaded
+    Accumulator accumulator;
+
+    // Recompute the accumulator if a network is loaded
+    void refreshAccumulator();
+
+    // Legal moves of the side to move, found by scanning every line from both ends
+    // If found_flips is given, the squares every found move flips are recorded in it
+    Bits scanMoves(std::array<Bits, CELLS>* found_flips) const;
+
+    // Squares flipped by a move, found by walking its lines
+    Bits walkFlips(uint8_t move) const;
+
+    // Place the move and its flips without updating the moves
+    void applyMove(uint8_t move, const Bits& flipped);
+
+    // Board after a legal move of the parent, see afterMove
+    BasicBoard(const BasicBoard& parent, uint8_t move, const Bits& flipped);
 
 public:
     // Initialize board by default
-    AstraDoBoard();
+    BasicBoard();
 
     // Initialize board from a given position
-    explicit AstraDoBoard(
-        const std::array<bool, 54>& black_array,
-        const std::array<bool, 54>& white_array,
+    explicit BasicBoard(
+        const Bits& black_bits,
+        const Bits& white_bits,
         bool next_turn
         );
 
     // Getter and setters
-    const std::array<bool, 54>& getBlackPieces() const;
+    const Bits& getBlackPieces() const;
 
-    const std::array<bool, 54>& getWhitePieces() const;
+    const Bits& getWhitePieces() const;
 
     const std::vector<uint8_t>& getMoves() const;
 
+    // Squares flipped by every legal move, in the order of getMoves
+    // Worked out by one scan of the lines, cheaper than making each move when all of them are needed
+    std::vector<Bits> findFlips() const;
+
     bool getTurn() const;
 
     void switchTurn();
@@ -55,14 +92,53 @@ public:
 
     std::pair<int, int> getPieceCount() const;
 
+    // Zobrist hash of the position, including side to move and stale flag
+    uint64_t getHash() const;
+
+    // Pieces that can never be flipped again, for black and white
+    std::pair<Bits, Bits> getStablePieces() const;
+
+    // Number of stable pieces for black and white
+    std::pair<int, int> getStableCount() const;
+
+    // First layer of the evaluation network, empty if no network was loaded
+    // and only valid if its generation matches the loaded network
+    const Accumulator& getAccumulator() const;
+
+    // Text form of the position: CELLS squares ('b' black, 'w' white, '.' empty),
+    // the side to move ('b' or 'w') and the stale flag (0 or 1), separated by spaces
+    std::string toString() const;
+
+    // Text form of a move: the square, or "pass" for a move >= CELLS
+    static std::string moveToString(uint8_t move);
+
+    // Read a position written by toString, returns false if the text is malformed
+    static bool fromString(const std::string& text, BasicBoard& board);
+
     // Find all current legal moves in the current state
     void findLegalMoves();
 
     // Note that this function does not check whether the move is legal
     // The check should be performed by caller before calling this method
-    // If move >= 54 (illegal move), the function will simply flip the side of the board
+    // If move >= CELLS (illegal move), the function will simply flip the side of the board
     void makeMove(uint8_t move);
 
+    // Make a move whose flipped squares are known, such as getMoves()[i] with findFlips()[i]
+    void makeMove(uint8_t move, Bits flipped);
+
+    // Board after a legal move whose flipped squares are known, without copying the moves of this board
+    BasicBoard afterMove(uint8_t move, const Bits& flipped) const;
+
 };
 
+// The board that is played
+using AstraDoBoard = BasicBoard<AstraDoGeometry>;
+
+// Geometries compiled into board.cpp
+extern template class BasicBoard<AstraDoGeometry>;
+extern template class BasicBoard<HexGeometry<3>>;
+extern template class BasicBoard<HexGeometry<4>>;
+extern template class BasicBoard<HexGeometry<5>>;
+extern template class BasicBoard<HexGeometry<6>>;
+
 #endif // BOARD_H
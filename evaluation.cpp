@@ -0,0 +1,69 @@
+#include "evaluation.h"
+#include <cmath>
+
+int AstraDoEvaluator::evaluate(const AstraDoBoard& board){
+    return evaluate(board, board.getStableCount());
+}
+
+int AstraDoEvaluator::evaluate(const AstraDoBoard& board, const std::pair<int, int>& stable_count){
+    const AstraDoBoard::Bits& black_pieces = board.getBlackPieces();
+    const AstraDoBoard::Bits& white_pieces = board.getWhitePieces();
+
+    int score = 0;
+    int black_count = 0, white_count = 0;
+    for(int i = 0; i < 54; ++i){
+        if(black_pieces[i]){
+            score += cell_weights[i];
+            ++black_count;
+        }
+        else if(white_pieces[i]){
+            score -= cell_weights[i];
+            ++white_count;
+        }
+    }
+    score += PIECE_WEIGHT * (black_count - white_count) * (black_count + white_count) / 54;
+    score += STABLE_WEIGHT * (stable_count.first - stable_count.second);
+    if(!board.getTurn()) score = -score;
+
+    // Mobility is taken from the move list that is already generated
+    score += MOBILITY_WEIGHT * static_cast<int>(board.getMoves().size());
+    return score;
+}
+
+double AstraDoEvaluator::winProbability(const AstraDoBoard& board){
+    // No legal moves can be made + previous move is stale
+    if(board.getMoves().empty() && board.getStale()){
+        std::pair<int, int> piece_count = board.getPieceCount();
+        if(piece_count.first > piece_count.second) return 1.0;
+        if(piece_count.first < piece_count.second) return 0.0;
+        return 0.5;
+    }
+    int score = evaluate(board);
+    if(!board.getTurn()) score = -score;
+    return 1.0 / (1.0 + std::exp(-score / WIN_PROBABILITY_SCALE));
+}
+
+bool AstraDoEvaluator::isQuiet(const AstraDoBoard& board){
+    // Edge squares are the ones weighted above the center of the board
+    for(uint8_t move : board.getMoves()){
+        if(cell_weights[move] > cell_weights[0]) return false;
+    }
+    return true;
+}
+
+int AstraDoEvaluator::getCellWeight(uint8_t pos){
+    return cell_weights[pos];
+}
+
+// Each group of 9 squares is one sixth of the board
+// Squares at the end of two lines are the easiest to keep,
+// squares next to them give the opponent access to the edge
+// Weights are fitted against results of random playouts
+const std::array<int, 54> AstraDoEvaluator::cell_weights = {
+    69, 69, 69, 69, 171, 64, 153, 64, 171,
+    69, 69, 69, 69, 171, 64, 153, 64, 171,
+    69, 69, 69, 69, 171, 64, 153, 64, 171,
+    69, 69, 69, 69, 171, 64, 153, 64, 171,
+    69, 69, 69, 69, 171, 64, 153, 64, 171,
+    69, 69, 69, 69, 171, 64, 153, 64, 171,
+};
@@ -0,0 +1,39 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "board.h"
+#include <array>
+#include <utility>
+
+// Static evaluation of AstraDo positions
+// Scores are given from the side to move, 1000 is about one unit of log-odds of winning
+class AstraDoEvaluator {
+private:
+    // Value of a piece on each square
+    static const std::array<int, 54> cell_weights;
+
+    // Raw piece count matters less than where the pieces are, scaled by how full the board is
+    static const int PIECE_WEIGHT = -105;
+    static const int MOBILITY_WEIGHT = 20;
+    static const int STABLE_WEIGHT = 145;
+
+    // Score difference that changes the odds of winning by a factor of e
+    static constexpr double WIN_PROBABILITY_SCALE = 1000.0;
+
+public:
+    // Evaluate by square weights, piece count, mobility of the side to move and stable pieces
+    static int evaluate(const AstraDoBoard& board);
+
+    // Same as above, with stable pieces of black and white already counted
+    static int evaluate(const AstraDoBoard& board, const std::pair<int, int>& stable_count);
+
+    // Probability that black wins, estimated from the evaluation
+    static double winProbability(const AstraDoBoard& board);
+
+    // A position is quiet if the side to move cannot take an edge square
+    static bool isQuiet(const AstraDoBoard& board);
+
+    static int getCellWeight(uint8_t pos);
+};
+
+#endif // EVALUATION_H
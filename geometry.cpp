@@ -0,0 +1,34 @@
+#include "geometry.h"
+
+const GeometryTables& AstraDoGeometry::tables(){
+    static const GeometryTables standard = GeometryTables::fromLines({
+        // Horizontal lines
+        {40, 35, 34, 33, 32, 31, 26},
+        {42, 41, 37, 30, 29, 28, 21, 25, 24},
+        {44, 43, 39, 38, 36, 27, 18, 20, 19, 23, 22},
+        {49, 50, 46, 47, 45,  0,  9, 11, 12, 16, 17},
+        {51, 52, 48,  1,  2,  3, 10, 14, 15},
+        {53,  4,  5,  6,  7,  8,  13},
+
+        // Top right to bottom left
+        {35, 40, 41, 42, 43, 44, 49},
+        {33, 34, 30, 37, 38, 39, 46, 50, 51},
+        {31, 32, 28, 29, 27, 36, 45, 47, 48, 52, 53},
+        {26, 25, 21, 20, 18,  9,  0,  2,  1,  5,  4},
+        {24, 23, 19, 12, 11, 10,  3,  7,  6},
+        {22, 17, 16, 15, 14, 13,  8},
+
+        // Top Left to bottom right
+        {31, 26, 25, 24, 23, 22, 17},
+        {33, 32, 28, 21, 20, 19, 12, 16, 15},
+        {35, 34, 30, 29, 27, 18,  9, 11, 10, 14, 13},
+        {40, 41, 37, 38, 36, 45,  0,  2,  3,  7,  8},
+        {42, 43, 39, 46, 47, 48,  1,  5,  6},
+        {44, 49, 50, 51, 52, 53,  4},
+        },
+        // Pos 0, 18, 36 are initially occupied by the side to play first (black)
+        {0, 18, 36},
+        // Pos 9, 27, 45 are initially occupied by the side to play second (white)
+        {9, 27, 45});
+    return standard;
+}
@@ -0,0 +1,223 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set of board cells, one bit per cell in 64-bit words
+template<int WORDS>
+class BoardBits {
+private:
+    std::array<uint64_t, WORDS> words{};
+
+    static int popcount(uint64_t word){
+#if defined(__GNUC__)
+        return __builtin_popcountll(word);
+#else
+        int count = 0;
+        for(; word; word &= word - 1) ++count;
+        return count;
+#endif
+    }
+
+    static int lowestBit(uint64_t word){
+#if defined(__GNUC__)
+        return __builtin_ctzll(word);
+#else
+        int bit = 0;
+        while(!((word >> bit) & 1)) ++bit;
+        return bit;
+#endif
+    }
+
+public:
+    bool operator[](int cell) const { return (words[cell >> 6] >> (cell & 63)) & 1; }
+
+    void set(int cell){ words[cell >> 6] |= uint64_t(1) << (cell & 63); }
+
+    void reset(int cell){ words[cell >> 6] &= ~(uint64_t(1) << (cell & 63)); }
+
+    uint64_t word(int index) const { return words[index]; }
+
+    void setWord(int index, uint64_t value){ words[index] = value; }
+
+    int count() const {
+        int total = 0;
+        for(uint64_t word : words) total += popcount(word);
+        return total;
+    }
+
+    bool any() const {
+        for(uint64_t word : words){
+            if(word) return true;
+        }
+        return false;
+    }
+
+    // Call f for every cell in the set, in increasing order
+    template<class F> void forEach(F f) const {
+        for(int i = 0; i < WORDS; ++i){
+            for(uint64_t word = words[i]; word; word &= word - 1) f(i * 64 + lowestBit(word));
+        }
+    }
+
+    BoardBits& operator|=(const BoardBits& other){
+        for(int i = 0; i < WORDS; ++i) words[i] |= other.words[i];
+        return *this;
+    }
+
+    BoardBits& operator&=(const BoardBits& other){
+        for(int i = 0; i < WORDS; ++i) words[i] &= other.words[i];
+        return *this;
+    }
+
+    BoardBits& operator^=(const BoardBits& other){
+        for(int i = 0; i < WORDS; ++i) words[i] ^= other.words[i];
+        return *this;
+    }
+
+    BoardBits operator|(const BoardBits& other) const { return BoardBits(*this) |= other; }
+
+    BoardBits operator&(const BoardBits& other) const { return BoardBits(*this) &= other; }
+
+    BoardBits operator^(const BoardBits& other) const { return BoardBits(*this) ^= other; }
+
+    bool operator==(const BoardBits& other) const { return words == other.words; }
+
+    bool operator!=(const BoardBits& other) const { return words != other.words; }
+};
+
+// Lines of a board and where every cell lies on them
+// Every cell is on exactly three lines, one per direction
+struct GeometryTables {
+    // Cells of every line, in order along the line
+    std::vector<std::vector<uint8_t>> lines;
+    // Line id and index within the line of every cell, in increasing order of line id
+    std::vector<std::array<std::array<uint8_t, 2>, 3>> squares;
+    // Cells occupied by black and white at the start of a game
+    std::vector<uint8_t> blackStart;
+    std::vector<uint8_t> whiteStart;
+
+    // Fill in squares from the lines
+    static GeometryTables fromLines(
+        std::vector<std::vector<uint8_t>> lines,
+        std::vector<uint8_t> black_start,
+        std::vector<uint8_t> white_start
+        ){
+        GeometryTables tables;
+        size_t cells = 0;
+        for(const std::vector<uint8_t>& line : lines) cells += line.size();
+        tables.squares.resize(cells / 3);
+        std::vector<int> found(cells / 3, 0);
+        for(size_t id = 0; id < lines.size(); ++id){
+            for(size_t index = 0; index < lines[id].size(); ++index){
+                uint8_t cell = lines[id][index];
+                tables.squares[cell][found[cell]++] = {static_cast<uint8_t>(id), static_cast<uint8_t>(index)};
+            }
+        }
+        tables.lines = std::move(lines);
+        tables.blackStart = std::move(black_start);
+        tables.whiteStart = std::move(white_start);
+        return tables;
+    }
+};
+
+// A geometry describes a board at compile time:
+// CELLS cells, LINES lines, PASS as the move of a side without legal moves,
+// NO_MOVE for no move at all, STANDARD if the evaluation, the network,
+// proof-number search and the file formats apply, and tables() for the lines
+
+// The 54-cell board that is played, with the cell numbering of the GUI and of all stored data
+struct AstraDoGeometry {
+    static constexpr int CELLS = 54;
+    static constexpr int LINES = 18;
+    static constexpr uint8_t PASS = 54;
+    static constexpr uint8_t NO_MOVE = 100;
+    static constexpr bool STANDARD = true;
+
+    static const GeometryTables& tables();
+};
+
+// Hexagon of triangles with SIDE triangles along every edge, 6 * SIDE^2 cells
+// Cells are numbered along the lines of the first direction
+// HexGeometry<3> has the lines of AstraDoGeometry under another numbering
+template<int SIDE>
+struct HexGeometry {
+    static constexpr int CELLS = 6 * SIDE * SIDE;
+    static constexpr int LINES = 6 * SIDE;
+    static constexpr uint8_t PASS = CELLS;
+    static constexpr uint8_t NO_MOVE = 255;
+    static constexpr bool STANDARD = false;
+
+    // Moves are stored in a byte, with room for PASS and NO_MOVE
+    static_assert(SIDE >= 2 && CELLS < 255, "unsupported board size");
+
+    static const GeometryTables& tables(){
+        static const GeometryTables generated = generate();
+        return generated;
+    }
+
+private:
+    // A triangle lies on one strip of every direction, strips are numbered 0 to 2 * SIDE - 1
+    // Triangles of the hexagon are those whose strip numbers add up to 3 * SIDE - 2 or 3 * SIDE - 1
+    static bool inside(int x, int y, int z){
+        int sum = x + y + z;
+        return x >= 0 && y >= 0 && z >= 0 && x < 2 * SIDE && y < 2 * SIDE && z < 2 * SIDE &&
+               (sum == 3 * SIDE - 2 || sum == 3 * SIDE - 1);
+    }
+
+    static GeometryTables generate(){
+        const int strips = 2 * SIDE;
+        // Number the cells strip by strip in the first direction, along the strip by y - z
+        std::vector<std::array<int, 3>> coordinates;
+        for(int x = 0; x < strips; ++x){
+            for(int d = -2 * strips; d <= 2 * strips; ++d){
+                for(int y = 0; y < strips; ++y){
+                    int z = y - d;
+                    if(inside(x, y, z)) coordinates.push_back({x, y, z});
+                }
+            }
+        }
+        auto cell_of = [&coordinates](const std::array<int, 3>& coordinate) {
+            for(size_t i = 0; i < coordinates.size(); ++i){
+                if(coordinates[i] == coordinate) return static_cast<uint8_t>(i);
+            }
+            return static_cast<uint8_t>(255);
+        };
+
+        // Along a strip of one direction the other two coordinates step in turn
+        std::vector<std::vector<uint8_t>> lines;
+        for(int direction = 0; direction < 3; ++direction){
+            int a = (direction + 1) % 3;
+            int b = (direction + 2) % 3;
+            for(int strip = 0; strip < strips; ++strip){
+                std::vector<uint8_t> line;
+                for(int d = -2 * strips; d <= 2 * strips; ++d){
+                    for(int u = 0; u < strips; ++u){
+                        std::array<int, 3> coordinate;
+                        coordinate[direction] = strip;
+                        coordinate[a] = u;
+                        coordinate[b] = u - d;
+                        if(inside(coordinate[0], coordinate[1], coordinate[2])) line.push_back(cell_of(coordinate));
+                    }
+                }
+                lines.push_back(line);
+            }
+        }
+
+        // Six triangles around the center, alternating in colour
+        std::vector<uint8_t> black_start, white_start;
+        for(const std::array<int, 3>& coordinate : coordinates){
+            bool central = true;
+            for(int value : coordinate) central = central && (value == SIDE - 1 || value == SIDE);
+            if(!central) continue;
+            bool pointing_up = coordinate[0] + coordinate[1] + coordinate[2] == 3 * SIDE - 2;
+            (pointing_up ? black_start : white_start).push_back(cell_of(coordinate));
+        }
+        return GeometryTables::fromLines(std::move(lines), std::move(black_start), std::move(white_start));
+    }
+};
+
+#endif // GEOMETRY_H
@@ -0,0 +1,151 @@
+#include "instrumentation.h"
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+
+namespace {
+
+const char* PHASE_NAMES[SEARCH_PHASES] = {"select", "expand", "simulate", "backpropagate"};
+
+// Trace being collected, guarded by traceMutex apart from the flag
+std::mutex traceMutex;
+std::atomic<bool> traceActive{false};
+std::string tracePath;
+std::chrono::steady_clock::time_point traceOrigin;
+std::ostringstream traceEvents;
+bool traceEmpty = true;
+
+// Small consecutive thread numbers read better in a trace viewer than native ids
+int threadNumber(){
+    static std::atomic<int> next{1};
+    thread_local int number = next.fetch_add(1);
+    return number;
+}
+
+}
+
+double SearchStats::iterationsPerSecond() const {
+    return seconds > 0 ? iterations / seconds : 0;
+}
+
+std::string SearchStats::toJson() const {
+    std::ostringstream json;
+    json << "{\"instrumented\": " << (instrumented ? "true" : "false")
+         << ", \"iterations\": " << iterations
+         << ", \"seconds\": " << seconds
+         << ", \"iterations_per_second\": " << iterationsPerSecond()
+         << ", \"tree_nodes\": " << treeNodes
+         << ", \"memory_bytes\": " << memoryBytes;
+    if(instrumented){
+        json << ", \"phase_seconds\": {";
+        for(int i = 0; i < SEARCH_PHASES; ++i){
+            json << (i > 0 ? ", " : "") << "\"" << PHASE_NAMES[i] << "\": " << phaseSeconds[i];
+        }
+        json << "}, \"max_depth\": " << maxDepth << ", \"average_depth\": " << averageDepth;
+        // Trailing empty buckets are left out
+        int size = ROLLOUT_HISTOGRAM_SIZE;
+        while(size > 0 && rolloutPlies[size - 1] == 0) --size;
+        json << ", \"rollout_plies\": [";
+        for(int i = 0; i < size; ++i) json << (i > 0 ? ", " : "") << rolloutPlies[i];
+        json << "]";
+    }
+    json << "}";
+    return json.str();
+}
+
+void SearchTrace::start(const std::string& file){
+    std::lock_guard<std::mutex> lock(traceMutex);
+    tracePath = file;
+    traceOrigin = std::chrono::steady_clock::now();
+    traceEvents.str("");
+    traceEmpty = true;
+    traceActive = true;
+}
+
+bool SearchTrace::stop(){
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if(!traceActive) return false;
+    traceActive = false;
+    std::FILE* file = std::fopen(tracePath.c_str(), "w");
+    if(!file) return false;
+    std::string events = traceEvents.str();
+    traceEvents.str("");
+    bool written = std::fprintf(file, "{\"traceEvents\": [%s\n], \"displayTimeUnit\": \"ms\"}\n", events.c_str()) > 0;
+    return std::fclose(file) == 0 && written;
+}
+
+bool SearchTrace::active(){
+    return traceActive.load(std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::time_point SearchTrace::getOrigin(){
+    std::lock_guard<std::mutex> lock(traceMutex);
+    return traceOrigin;
+}
+
+void SearchTrace::add(const std::vector<TraceEvent>& events){
+    int thread = threadNumber();
+    // Format outside the lock, searches on other threads may be finishing too
+    std::ostringstream text;
+    text.precision(3);
+    text << std::fixed;
+    for(const TraceEvent& event : events){
+        text << ",\n{\"name\": \"" << PHASE_NAMES[static_cast<int>(event.phase)]
+             << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread
+             << ", \"ts\": " << event.start << ", \"dur\": " << event.duration << "}";
+    }
+    std::string block = text.str();
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if(!traceActive || block.empty()) return;
+    // First event has no separator
+    traceEvents << (traceEmpty ? block.substr(1) : block);
+    traceEmpty = false;
+}
+
+void SearchInstrumentation::begin(){
+    *this = SearchInstrumentation();
+    tracing = SearchTrace::active();
+}
+
+void SearchInstrumentation::enter(SearchPhase phase){
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(current >= 0){
+        phaseTime[current] += now - phaseStart;
+        if(tracing && events.size() < SearchTrace::MAX_EVENTS_PER_SEARCH){
+            // Times are made relative to the trace origin when the search ends
+            events.push_back({static_cast<SearchPhase>(current),
+                              std::chrono::duration<double, std::micro>(phaseStart.time_since_epoch()).count(),
+                              std::chrono::duration<double, std::micro>(now - phaseStart).count()});
+        }
+    }
+    current = static_cast<int>(phase);
+    phaseStart = now;
+}
+
+void SearchInstrumentation::leave(){
+    enter(SearchPhase::Select);
+    current = -1;
+}
+
+void SearchInstrumentation::rollout(int plies){
+    ++rolloutPlies[plies < ROLLOUT_HISTOGRAM_SIZE ? plies : ROLLOUT_HISTOGRAM_SIZE - 1];
+}
+
+void SearchInstrumentation::end(){
+    if(!tracing || events.empty()) return;
+    double origin = std::chrono::duration<double, std::micro>(SearchTrace::getOrigin().time_since_epoch()).count();
+    for(TraceEvent& event : events) event.start -= origin;
+    SearchTrace::add(events);
+    events.clear();
+}
+
+void SearchInstrumentation::fill(SearchStats& stats) const {
+    stats.instrumented = true;
+    for(int i = 0; i < SEARCH_PHASES; ++i){
+        stats.phaseSeconds[i] = std::chrono::duration<double>(phaseTime[i]).count();
+    }
+    stats.maxDepth = maxDepth;
+    stats.averageDepth = depthCount > 0 ? static_cast<double>(depthSum) / depthCount : 0;
+    stats.rolloutPlies = rolloutPlies;
+}
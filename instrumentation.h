@@ -0,0 +1,134 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Parts of an MCTS iteration that are timed separately
+// Proof-number search of a node about to be expanded counts as expansion
+enum class SearchPhase { Select, Expand, Simulate, Backpropagate };
+const int SEARCH_PHASES = 4;
+
+// Rollouts of at least this many plies share the last histogram bucket
+const int ROLLOUT_HISTOGRAM_SIZE = 64;
+
+// Summary of one search
+struct SearchStats {
+    // Only the totals are filled in unless the engine is built with ASTRADO_INSTRUMENTATION
+    bool instrumented = false;
+    long long iterations = 0;
+    double seconds = 0;
+    long long treeNodes = 0;
+    size_t memoryBytes = 0;
+
+    // Time spent in each SearchPhase
+    std::array<double, SEARCH_PHASES> phaseSeconds{};
+    // Depth of the nodes reached by selection, the root is at depth 0
+    int maxDepth = 0;
+    double averageDepth = 0;
+    // Number of rollouts by the plies they played, passes included
+    std::array<long long, ROLLOUT_HISTOGRAM_SIZE> rolloutPlies{};
+
+    double iterationsPerSecond() const;
+
+    // One JSON object on a single line
+    std::string toJson() const;
+};
+
+// One timed phase of a search on the trace timeline
+struct TraceEvent {
+    SearchPhase phase;
+    // Microseconds since the trace started
+    double start;
+    double duration;
+};
+
+// Collects the timelines of every instrumented search into one Chrome trace-event file,
+// viewable in chrome://tracing or Perfetto with one row per thread
+class SearchTrace {
+public:
+    // Events kept per search, later phases of a long search are left out
+    static const size_t MAX_EVENTS_PER_SEARCH = 1 << 18;
+
+    // Start collecting, searches already running are not recorded
+    static void start(const std::string& file);
+
+    // Write the file and stop collecting, returns false if it cannot be written
+    static bool stop();
+
+    static bool active();
+
+    static std::chrono::steady_clock::time_point getOrigin();
+
+    // Add the events of one search that ran on the calling thread
+    static void add(const std::vector<TraceEvent>& events);
+};
+
+// Instrumentation that records nothing, every call compiles away
+class NullInstrumentation {
+public:
+    void begin() {}
+    void enter(SearchPhase) {}
+    void leave() {}
+    template<class Node> void reached(const Node*) {}
+    void rollout(int) {}
+    void end() {}
+    void fill(SearchStats&) const {}
+};
+
+// Records phase times, selection depths and rollout lengths of a search
+class SearchInstrumentation {
+private:
+    std::array<std::chrono::steady_clock::duration, SEARCH_PHASES> phaseTime{};
+    // Phase being timed and when it started
+    int current = -1;
+    std::chrono::steady_clock::time_point phaseStart;
+
+    int maxDepth = 0;
+    long long depthSum = 0;
+    long long depthCount = 0;
+    std::array<long long, ROLLOUT_HISTOGRAM_SIZE> rolloutPlies{};
+
+    // Only recorded while a SearchTrace is active
+    bool tracing = false;
+    std::vector<TraceEvent> events;
+
+public:
+    // Start of a run, earlier statistics are cleared
+    void begin();
+
+    // Close the current phase and time the next one
+    void enter(SearchPhase phase);
+
+    // Close the current phase
+    void leave();
+
+    // Depth of a node reached by selection
+    template<class Node> void reached(const Node* node){
+        int depth = 0;
+        for(node = node->getParent(); node; node = node->getParent()) ++depth;
+        if(depth > maxDepth) maxDepth = depth;
+        depthSum += depth;
+        ++depthCount;
+    }
+
+    void rollout(int plies);
+
+    // End of a run, hands the timeline to the trace
+    void end();
+
+    void fill(SearchStats& stats) const;
+};
+
+// Choose the instrumentation at compile time, the default build pays nothing for it
+#ifdef ASTRADO_INSTRUMENTATION
+using MCTSInstrumentation = SearchInstrumentation;
+#else
+using MCTSInstrumentation = NullInstrumentation;
+#endif
+
+#endif // INSTRUMENTATION_H
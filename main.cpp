@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "nnue.h"
 
 // #include <QApplication>
 // #include <QWidget>
@@ -16,6 +17,8 @@ int main(int argc, char *argv[])
 {
 
     QApplication a(argc, argv);
+    // Evaluation network is optional, MCTS keeps random rollouts without it
+    AstraDoNetwork::load(QCoreApplication::applicationDirPath().toStdString() + "/astrado.nnue");
     MainWindow window;
     window.resize(800, 800);
     window.show();
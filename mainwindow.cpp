@@ -4,7 +4,8 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
     scene(new QGraphicsScene(this)),
     view(new QGraphicsView(this)),
-    board(AstraDoBoard())
+    board(AstraDoBoard()),
+    searchTimer(new QTimer(this))
 {
     // Set up the main widget and layout
     QWidget *mainContainer = new QWidget(this);
@@ -42,12 +43,23 @@ MainWindow::MainWindow(QWidget *parent)
     playMyselfButton = new QPushButton("Play Myself");
     restartButton = new QPushButton("Restart");
     noLegalMoveButton = new QPushButton("No Legal Moves");
+    engineSelector = new QComboBox();
+    engineSelector->addItem("MCTS");
+    engineSelector->addItem("Alpha-Beta");
+    heatmapCheckBox = new QCheckBox("Show search heatmap");
 
     connect(playAsBlackButton, &QPushButton::clicked, this, &MainWindow::playAsBlack);
     connect(playAsWhiteButton, &QPushButton::clicked, this, &MainWindow::playAsWhite);
     connect(playMyselfButton, &QPushButton::clicked, this, &MainWindow::playMyself);
     connect(noLegalMoveButton, &QPushButton::clicked, this, &MainWindow::skipMove);
     connect(restartButton, &QPushButton::clicked, this, &MainWindow::restartGame);
+    connect(engineSelector, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index){
+        searchAlgorithm = index == 1 ? SearchAlgorithm::AlphaBeta : SearchAlgorithm::MCTS;
+    });
+    connect(heatmapCheckBox, &QCheckBox::toggled, this, [this](bool checked){
+        if(!checked) clearHeatmap();
+    });
+    connect(searchTimer, &QTimer::timeout, this, &MainWindow::updateSearchProgress);
 
     blackPieceCountLabel = new QLabel("");
     whitePieceCountLabel = new QLabel("");
@@ -59,11 +71,13 @@ MainWindow::MainWindow(QWidget *parent)
     menuLayout->addWidget(playMyselfButton, 1, 0, 1, 2);  // Span across 2 columns
     menuLayout->addWidget(restartButton, 2, 0);
     menuLayout->addWidget(noLegalMoveButton, 2, 1);
+    menuLayout->addWidget(engineSelector, 3, 0, 1, 2);
+    menuLayout->addWidget(heatmapCheckBox, 4, 0, 1, 2);
 
-    menuLayout->addWidget(blackPieceCountLabel, 3, 0, 1, 2);
-    menuLayout->addWidget(whitePieceCountLabel, 4, 0, 1, 2);
-    menuLayout->addWidget(currentTurnLabel, 5, 0, 1, 2);
-    menuLayout->addWidget(notesLabel, 6, 0, 1, 2);
+    menuLayout->addWidget(blackPieceCountLabel, 5, 0, 1, 2);
+    menuLayout->addWidget(whitePieceCountLabel, 6, 0, 1, 2);
+    menuLayout->addWidget(currentTurnLabel, 7, 0, 1, 2);
+    menuLayout->addWidget(notesLabel, 8, 0, 1, 2);
 
     menuContainer->setLayout(menuLayout);
 
@@ -80,10 +94,11 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-
+    stopAIMove();
 }
 
 void MainWindow::restartGame(){
+    stopAIMove();
     board = AstraDoBoard();
     gameStatus = GameStatus::Init;
     // 100 indicates do not print legal moves
@@ -92,6 +107,7 @@ void MainWindow::restartGame(){
 }
 
 void MainWindow::playAsBlack(){
+    stopAIMove();
     gameStatus = GameStatus::PlayAsBlack;
     // AI plays the current move
     if(board.getTurn() == false){
@@ -111,6 +127,7 @@ void MainWindow::playAsBlack(){
     }
 }
 void MainWindow::playAsWhite(){
+    stopAIMove();
     gameStatus = GameStatus::PlayAsWhite;
     // AI plays the current move
     if(board.getTurn() == true){
@@ -131,6 +148,7 @@ void MainWindow::playAsWhite(){
 }
 
 void MainWindow::playMyself(){
+    stopAIMove();
     gameStatus = GameStatus::PlayMyself;
     // 54 indicates game just started
     setTriangleStatus(54);
@@ -193,40 +211,75 @@ void MainWindow::onTriangleClicked(int moveID){
 }
 
 void MainWindow::setTriangleStatus(uint8_t moveID){
+    // Work out every new status first, then only repaint the triangles that changed
+    std::array<Triangle::TriangleStatus, 54> status;
     for(int i = 0; i < 54; ++i){
-        if(board.getBlackPieces()[i]) triangles[i]->changeStatus(Triangle::TriangleStatus::BLACK);
-        else if(board.getWhitePieces()[i]) triangles[i]->changeStatus(Triangle::TriangleStatus::WHITE);
-        else triangles[i]->changeStatus(Triangle::TriangleStatus::EMPTY);
+        if(board.getBlackPieces()[i]) status[i] = Triangle::TriangleStatus::BLACK;
+        else if(board.getWhitePieces()[i]) status[i] = Triangle::TriangleStatus::WHITE;
+        else status[i] = Triangle::TriangleStatus::EMPTY;
     }
     // Game not started, so do not print moves
-    if(moveID > 54){
-        return;
-    }
-    // Game just started, or previous move is skip
-    else if(moveID == 54){
+    // Game just started, or previous move is skip (54), only print moves
+    if(moveID <= 54){
         for(uint8_t move : board.getMoves()){
-            triangles[move]->changeStatus(Triangle::TriangleStatus::NEXT);
-        }
-    }
-    else{
-        for(uint8_t move : board.getMoves()){
-            triangles[move]->changeStatus(Triangle::TriangleStatus::NEXT);
+            status[move] = Triangle::TriangleStatus::NEXT;
         }
         // Current turn is black, last turn is white
-        if(board.getTurn()){
-            triangles[moveID]->changeStatus(Triangle::TriangleStatus::WHITE_LAST);
-        }
         // Current turn is white, last turn is black
-        else{
-            triangles[moveID]->changeStatus(Triangle::TriangleStatus::BLACK_LAST);
+        if(moveID < 54){
+            status[moveID] = board.getTurn() ? Triangle::TriangleStatus::WHITE_LAST : Triangle::TriangleStatus::BLACK_LAST;
         }
     }
+    std::vector<int> changed;
+    for(int i = 0; i < 54; ++i){
+        if(triangles[i]->setStatus(status[i])) changed.push_back(i);
+    }
+    repaintTriangles(changed);
+}
+
+void MainWindow::repaintTriangles(const std::vector<int>& changed){
+    if(changed.empty()) return;
+    QRectF dirty;
+    for(int i : changed) dirty = dirty.united(triangles[i]->sceneBoundingRect());
+    scene->update(dirty);
 }
 
 void MainWindow::makeAIMove(){
-    // Let MCTS make the next move
-    MCTS mcts(board, MCTS_ITERS);
-    uint8_t move = mcts.getBestMove();
+    // Let the selected engine make the next move
+    SearchBudget budget;
+    if(searchAlgorithm == SearchAlgorithm::MCTS) budget.nodes = MCTS_ITERS;
+    else budget.timeMs = ALPHA_BETA_TIME_MS;
+    std::unique_ptr<SearchEngine> engine = createSearchEngine(searchAlgorithm, board, budget);
+    engine->setStopFlag(&searchStop);
+    // Only MCTS reports its root moves
+    if(MCTS* mcts = dynamic_cast<MCTS*>(engine.get())){
+        mcts->setAnalysis(&analysisChannel, ANALYSIS_MAX_LINES, HEATMAP_INTERVAL_MS);
+    }
+    // Snapshots of the previous search are dropped
+    analysisChannel.read(analysis);
+    searchStop = false;
+    searchDone = false;
+    // The search works on its own copy of the board, the window stays responsive
+    searchThread = std::thread([this, engine = std::move(engine)](){
+        searchMove = engine->getBestMove();
+        searchDone = true;
+    });
+    searchTimer->start(HEATMAP_INTERVAL_MS);
+}
+
+void MainWindow::updateSearchProgress(){
+    if(searchDone){
+        finishAIMove();
+        return;
+    }
+    if(heatmapCheckBox->isChecked() && analysisChannel.read(analysis)) updateHeatmap();
+}
+
+void MainWindow::finishAIMove(){
+    searchTimer->stop();
+    searchThread.join();
+    clearHeatmap();
+    uint8_t move = searchMove;
     board.makeMove(move);
     // Game ends
     if(board.getMoves().size() == 0 && board.getStale()){
@@ -237,6 +290,40 @@ void MainWindow::makeAIMove(){
     updateLabels();
 }
 
+void MainWindow::stopAIMove(){
+    if(!searchThread.joinable()) return;
+    searchStop = true;
+    searchTimer->stop();
+    searchThread.join();
+    clearHeatmap();
+    aiThinking = false;
+}
+
+void MainWindow::updateHeatmap(){
+    // Colour by share of visits, relative to the most visited move
+    int max_visits = 0;
+    for(int i = 0; i < analysis.lineCount; ++i) max_visits = std::max(max_visits, analysis.lines[i].visits);
+    std::array<double, 54> heat;
+    heat.fill(-1);
+    for(int i = 0; i < analysis.lineCount && max_visits > 0; ++i){
+        const AnalysisLine& line = analysis.lines[i];
+        if(line.move < 54) heat[line.move] = static_cast<double>(line.visits) / max_visits;
+    }
+    std::vector<int> changed;
+    for(int i = 0; i < 54; ++i){
+        if(triangles[i]->setHeat(heat[i])) changed.push_back(i);
+    }
+    repaintTriangles(changed);
+}
+
+void MainWindow::clearHeatmap(){
+    std::vector<int> changed;
+    for(int i = 0; i < 54; ++i){
+        if(triangles[i]->setHeat(-1)) changed.push_back(i);
+    }
+    repaintTriangles(changed);
+}
+
 void MainWindow::skipMove(){
     // Only active when there are no moves to be played
     // And game is still ongoing
@@ -4,6 +4,8 @@
 #include "triangle.h"
 #include "board.h"
 #include "mcts.h"
+#include "search.h"
+#include "analysis.h"
 
 #include <QString>
 
@@ -12,12 +14,19 @@
 #include <QGraphicsView>
 #include <QPushButton>
 #include <QLabel>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QTimer>
 
 #include <QHBoxLayout>
 #include <QGridLayout>
 
 #include <QCoreApplication>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -41,6 +50,8 @@ private:
     QPushButton *playMyselfButton;
     QPushButton *restartButton;
     QPushButton *noLegalMoveButton;
+    QComboBox *engineSelector;
+    QCheckBox *heatmapCheckBox;
     QLabel *blackPieceCountLabel;
     QLabel *whitePieceCountLabel;
     QLabel *currentTurnLabel;
@@ -50,7 +61,18 @@ private:
     enum class GameStatus { Init, PlayAsWhite, PlayAsBlack, PlayMyself, GameEnds };
     GameStatus gameStatus = GameStatus::Init;
     bool aiThinking = false;
-
+    SearchAlgorithm searchAlgorithm = SearchAlgorithm::MCTS;
+
+    // AI searches on its own thread, the timer polls it at a fixed frame rate
+    std::thread searchThread;
+    QTimer *searchTimer;
+    std::atomic<bool> searchDone{false};
+    std::atomic<bool> searchStop{false};
+    // Written by the search thread before it sets searchDone
+    uint8_t searchMove = 54;
+    // Root statistics of a running MCTS search, for the heatmap
+    AnalysisChannel analysisChannel;
+    AnalysisSnapshot analysis;
 
     static const std::array<bool, 54> triangle_direction;
     static const std::vector<std::vector<int>> triangle_relative_pos;
@@ -63,6 +85,14 @@ private:
     static const int SCENE_HEIGHT = 450;
 
     static const int MCTS_ITERS = 25000;
+    static const int ALPHA_BETA_TIME_MS = 1500;
+    // Refresh interval of the search heatmap, about 30 frames per second
+    static const int HEATMAP_INTERVAL_MS = 33;
+
+    // Repaint the given triangles with a single scene update
+    void repaintTriangles(const std::vector<int>& changed);
+    void updateHeatmap();
+    void clearHeatmap();
 
 public:
     void restartGame();
@@ -72,6 +102,11 @@ public:
     void onTriangleClicked(int moveID);
     void setTriangleStatus(uint8_t moveID);
     void makeAIMove();
+    // Called by the timer while the AI is thinking
+    void updateSearchProgress();
+    void finishAIMove();
+    // Abort a running AI search, its move is discarded
+    void stopAIMove();
     void skipMove();
     void updateLabels();
 
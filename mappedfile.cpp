@@ -0,0 +1,87 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path){
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0){
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mapping){
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!view){
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    fileData = static_cast<const uint8_t*>(view);
+    fileSize = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close(){
+    if(fileData) UnmapViewOfFile(fileData);
+    if(mappingHandle) CloseHandle(mappingHandle);
+    if(fileHandle) CloseHandle(fileHandle);
+    fileData = nullptr;
+    fileSize = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path){
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size == 0){
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if(view == MAP_FAILED) return false;
+    // The file is read once from front to back
+    madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    fileData = static_cast<const uint8_t*>(view);
+    fileSize = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close(){
+    if(fileData) munmap(const_cast<uint8_t*>(fileData), fileSize);
+    fileData = nullptr;
+    fileSize = 0;
+}
+
+#endif
+
+const uint8_t* MappedFile::data() const { return fileData; }
+
+size_t MappedFile::size() const { return fileSize; }
@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file
+// The operating system pages the file in on demand, nothing is copied up front
+class MappedFile {
+private:
+    const uint8_t* fileData = nullptr;
+    size_t fileSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file, returns false if it cannot be opened or mapped
+    bool open(const std::string& path);
+
+    void close();
+
+    const uint8_t* data() const;
+
+    size_t size() const;
+};
+
+#endif // MAPPEDFILE_H
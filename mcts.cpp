@@ -1,168 +1,1020 @@
 #include "mcts.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
-MCTSNode::MCTSNode(
-    AstraDoBoard board,
-    MCTSNode* parent,
+namespace {
+
+// Exact result of a finished game
+template<class Geometry>
+BasicRolloutResult<Geometry> gameResult(
+    const BasicBoard<Geometry>& board,
+    const std::array<uint8_t, Geometry::CELLS>& played,
+    int plies = 0
+    ){
+    std::pair<int, int> piece_count = board.getPieceCount();
+    double score = piece_count.first - piece_count.second;
+    return {score, score > 0 ? 1.0 : (score < 0 ? -1.0 : 0.0), played, plies};
+}
+
+// Checkpoint layout, in native byte order:
+// one TreeHeader, then one NodeRecord per node in depth-first pre-order
+// Boards are not stored, they are replayed from the root position
+const char TREE_MAGIC[4] = {'A', 'D', 'M', 'T'};
+const uint32_t TREE_VERSION = 1;
+
+struct TreeHeader {
+    char magic[4];
+    uint32_t version;
+    // Root position, bit i is set if square i is occupied
+    uint64_t black;
+    uint64_t white;
+    uint8_t turn;
+    uint8_t stale;
+    uint8_t reserved[6];
+    uint64_t nodeCount;
+};
+
+struct NodeRecord {
+    int32_t numVisits;
+    int32_t amafVisits;
+    double winSum;
+    double scoreSum;
+    double amafWinSum;
+    uint8_t move;
+    uint8_t proven;
+    uint8_t numChildren;
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(TreeHeader) == 40, "checkpoint header must have no padding");
+static_assert(sizeof(NodeRecord) == 40, "checkpoint record must have no padding");
+
+// Expected result of an unfinished game, by the network if one is loaded
+// Other geometries have no evaluation, their positions count as even
+template<class Geometry>
+BasicRolloutResult<Geometry> estimatedResult(
+    const BasicBoard<Geometry>& board,
+    const std::array<uint8_t, Geometry::CELLS>& played,
+    int plies = 0
+    ){
+    std::pair<int, int> piece_count = board.getPieceCount();
+    double win_probability = 0.5;
+    if constexpr(Geometry::STANDARD){
+        const AstraDoNetwork* network = AstraDoNetwork::active();
+        win_probability = network ? network->winProbability(board) : AstraDoEvaluator::winProbability(board);
+    }
+    return {static_cast<double>(piece_count.first - piece_count.second), 2 * win_probability - 1, played, plies};
+}
+
+}
+
+template<class Geometry>
+BasicMCTSNode<Geometry>::BasicMCTSNode(
+    Board board,
+    Node* parent,
     uint8_t move
     ) :
-    board(board),
+    board(std::move(board)),
     parent(parent),
     move(move){
 
 }
 
-MCTSNode::~MCTSNode() {
-    for(MCTSNode* child : children){
+template<class Geometry>
+BasicMCTSNode<Geometry>::~BasicMCTSNode() {
+    for(Node* child : children){
         delete child;
     }
 }
 
-void MCTSNode::expand(){
+template<class Geometry>
+void BasicMCTSNode<Geometry>::expand(){
     if(board.getMoves().empty()){
-        AstraDoBoard newState(board);
-        newState.makeMove(100);
-        children.push_back(new MCTSNode(newState, this, 100));
+        Board newState(board);
+        newState.makeMove(Geometry::NO_MOVE);
+        children.push_back(new Node(std::move(newState), this, Geometry::NO_MOVE));
     }
     else{
-        for(uint8_t move : board.getMoves()){
-            AstraDoBoard newState(board);
-            newState.makeMove(move);
-            children.push_back(new MCTSNode(newState, this, move));
+        // One scan of the lines gives the flips of every move, so the children need no walk of their own
+        const std::vector<uint8_t>& moves = board.getMoves();
+        std::vector<typename Board::Bits> flips = board.findFlips();
+        for(size_t i = 0; i < moves.size(); ++i){
+            children.push_back(new Node(board.afterMove(moves[i], flips[i]), this, moves[i]));
         }
     }
 }
 
+template<class Geometry>
+void BasicMCTSNode<Geometry>::collapse(){
+    for(Node* child : children){
+        delete child;
+    }
+    children.clear();
+    children.shrink_to_fit();
+}
+
+template<class Geometry>
+BasicMCTSNode<Geometry>* BasicMCTSNode<Geometry>::addChild(uint8_t move){
+    Board newState(board);
+    newState.makeMove(move);
+    children.push_back(new Node(std::move(newState), this, move));
+    return children.back();
+}
+
+template<class Geometry>
+BasicMCTSNode<Geometry>* BasicMCTSNode<Geometry>::detachChild(uint8_t move){
+    for(size_t i = 0; i < children.size(); ++i){
+        Node* child = children[i];
+        if(child->move == move || (child->move >= Geometry::CELLS && move >= Geometry::CELLS)){
+            children.erase(children.begin() + i);
+            child->parent = nullptr;
+            return child;
+        }
+    }
+    return nullptr;
+}
+
 // Getters
-const AstraDoBoard& MCTSNode::getAstraDoBoard() const { return board; }
+template<class Geometry>
+const BasicBoard<Geometry>& BasicMCTSNode<Geometry>::getAstraDoBoard() const { return board; }
 
-MCTSNode* MCTSNode::getParent() const { return parent; }
+template<class Geometry>
+BasicMCTSNode<Geometry>* BasicMCTSNode<Geometry>::getParent() const { return parent; }
 
-const std::vector<MCTSNode*>& MCTSNode::getChildren() const { return children; }
+template<class Geometry>
+const std::vector<BasicMCTSNode<Geometry>*>& BasicMCTSNode<Geometry>::getChildren() const { return children; }
 
-uint8_t MCTSNode::getMove() const { return move; }
+template<class Geometry>
+uint8_t BasicMCTSNode<Geometry>::getMove() const { return move; }
 
-bool MCTSNode::isTerminal() const {
+template<class Geometry>
+bool BasicMCTSNode<Geometry>::isTerminal() const {
     // No legal moves can be made + previous move is stale
     return board.getMoves().size() == 0 && board.getStale();
 }
 
-double MCTSNode::getAvgScore() const { return scoreSum / numVisits; }
+template<class Geometry>
+double BasicMCTSNode<Geometry>::getAvgScore() const { return scoreSum / numVisits; }
 
-double MCTSNode::getAvgWinSum() const { return winSum / numVisits; }
+template<class Geometry>
+double BasicMCTSNode<Geometry>::getAvgWinSum() const { return winSum / numVisits; }
 
-int MCTSNode::getNumVisits() const { return numVisits; }
+template<class Geometry>
+int BasicMCTSNode<Geometry>::getNumVisits() const { return numVisits; }
 
-void MCTSNode::update(double score){
-    this->scoreSum += score;
-    if(score > 0){
-        winSum += 1;
-    }
-    else if (score < 0){
-        winSum -= 1;
+template<class Geometry>
+double BasicMCTSNode<Geometry>::getAvgAmafWinSum() const { return amafWinSum / amafVisits; }
+
+template<class Geometry>
+int BasicMCTSNode<Geometry>::getAmafVisits() const { return amafVisits; }
+
+template<class Geometry>
+ProvenResult BasicMCTSNode<Geometry>::getProven() const { return proven; }
+
+template<class Geometry>
+bool BasicMCTSNode<Geometry>::isProven() const { return proven != ProvenResult::Unknown; }
+
+template<class Geometry>
+size_t BasicMCTSNode<Geometry>::getMemoryUsage() const {
+    size_t bytes = sizeof(Node) + ALLOCATION_OVERHEAD;
+    if(board.getMoves().capacity() > 0) bytes += board.getMoves().capacity() + ALLOCATION_OVERHEAD;
+    if(children.capacity() > 0) bytes += children.capacity() * sizeof(Node*) + ALLOCATION_OVERHEAD;
+    if constexpr(Geometry::STANDARD){
+        if(board.getAccumulator().get()) bytes += sizeof(NnueAccumulator) + ALLOCATION_OVERHEAD;
     }
+    return bytes;
+}
+
+template<class Geometry>
+void BasicMCTSNode<Geometry>::setProven(ProvenResult result) { proven = result; }
+
+template<class Geometry>
+MCTSNodeStatistics BasicMCTSNode<Geometry>::getStatistics() const {
+    return {numVisits, winSum, scoreSum, amafVisits, amafWinSum, proven};
+}
+
+template<class Geometry>
+void BasicMCTSNode<Geometry>::setStatistics(const MCTSNodeStatistics& statistics){
+    numVisits = statistics.numVisits;
+    winSum = statistics.winSum;
+    scoreSum = statistics.scoreSum;
+    amafVisits = statistics.amafVisits;
+    amafWinSum = statistics.amafWinSum;
+    proven = statistics.proven;
+}
+
+template<class Geometry>
+void BasicMCTSNode<Geometry>::update(const RolloutResult& result){
+    scoreSum += result.score;
+    winSum += result.win;
     ++numVisits;
 }
 
-double MCTSNode::random_rollout() const {
+template<class Geometry>
+void BasicMCTSNode<Geometry>::updateAmaf(double win){
+    amafWinSum += win;
+    ++amafVisits;
+}
+
+template<class Geometry>
+bool BasicMCTSNode<Geometry>::updateProven(){
+    if(proven != ProvenResult::Unknown) return false;
 
-    AstraDoBoard rollout_board(board);
+    // Game has ended, the result is given by the piece count
+    if(isTerminal()){
+        std::pair<int, int> piece_count = board.getPieceCount();
+        if(piece_count.first > piece_count.second) proven = ProvenResult::BlackWin;
+        else if(piece_count.first < piece_count.second) proven = ProvenResult::WhiteWin;
+        else proven = ProvenResult::Draw;
+        return true;
+    }
+
+    // Leaf node, nothing is known yet
+    if(children.empty()) return false;
+
+    // The side to move picks the best among its children
+    ProvenResult win = board.getTurn() ? ProvenResult::BlackWin : ProvenResult::WhiteWin;
+    ProvenResult loss = board.getTurn() ? ProvenResult::WhiteWin : ProvenResult::BlackWin;
+    bool all_proven = true;
+    bool has_draw = false;
+    for(Node* child : children){
+        // A single winning move is enough
+        if(child->proven == win){
+            proven = win;
+            return true;
+        }
+        if(child->proven == ProvenResult::Unknown) all_proven = false;
+        else if(child->proven == ProvenResult::Draw) has_draw = true;
+    }
+
+    // Some moves are still uncertain
+    if(!all_proven) return false;
+
+    proven = has_draw ? ProvenResult::Draw : loss;
+    return true;
+}
+
+template<class Geometry>
+BasicRolloutResult<Geometry> BasicMCTSNode<Geometry>::random_rollout(std::mt19937& rng) const {
+
+    Board rollout_board(board);
+    std::array<uint8_t, Geometry::CELLS> played{};
+    int ply = 0;
 
     while(true){
         // No legal moves can be made
         if(rollout_board.getMoves().size() == 0){
             // No potential moves for both sides, return piece count
             if(rollout_board.getStale()){
-                std::pair<int, int> piece_count = rollout_board.getPieceCount();
-                return piece_count.first - piece_count.second;
+                return gameResult(rollout_board, played, ply);
             }
             else{
                 // Skip the move for the side
-                rollout_board.makeMove(100);
+                rollout_board.makeMove(Geometry::NO_MOVE);
             }
         }
         else{
             // Randomly plays a move
-            rollout_board.makeMove(rollout_board.getMoves()[rand() % rollout_board.getMoves().size()]);
+            size_t index = rng() % rollout_board.getMoves().size();
+            uint8_t move = rollout_board.getMoves()[index];
+            played[move] = rollout_board.getTurn() ? 1 : 2;
+            rollout_board.makeMove(move);
+        }
+
+        // Once a side holds more than half of the board in stable pieces the winner is decided
+        // Checked every few plies only, as the analysis costs about as much as a move
+        if(++ply % STABILITY_CHECK_PLIES != 0) continue;
+        std::pair<int, int> piece_count = rollout_board.getPieceCount();
+        if(std::max(piece_count.first, piece_count.second) > Geometry::CELLS / 2){
+            std::pair<int, int> stable_count = rollout_board.getStableCount();
+            if(std::max(stable_count.first, stable_count.second) > Geometry::CELLS / 2){
+                return gameResult(rollout_board, played, ply);
+            }
+        }
+    }
+
+}
+
+template<class Geometry>
+BasicRolloutResult<Geometry> BasicMCTSNode<Geometry>::truncated_rollout(int max_plies, std::mt19937& rng) const {
+    Board rollout_board(board);
+    std::array<uint8_t, Geometry::CELLS> played{};
+    int ply = 0;
+
+    for(; ply < max_plies; ++ply){
+        // Late plies carry little signal, stop once nothing big can happen
+        if constexpr(Geometry::STANDARD){
+            if(ply >= MIN_TRUNCATED_PLIES && AstraDoEvaluator::isQuiet(rollout_board)) break;
+        }
+
+        if(rollout_board.getMoves().empty()){
+            // No potential moves for both sides, return piece count
+            if(rollout_board.getStale()) return gameResult(rollout_board, played, ply);
+            // Skip the move for the side
+            rollout_board.makeMove(Geometry::NO_MOVE);
+        }
+        else{
+            // Randomly plays a move
+            size_t index = rng() % rollout_board.getMoves().size();
+            uint8_t move = rollout_board.getMoves()[index];
+            played[move] = rollout_board.getTurn() ? 1 : 2;
+            rollout_board.makeMove(move);
         }
     }
 
+    // Game may have ended on the last ply
+    if(rollout_board.getMoves().empty() && rollout_board.getStale()) return gameResult(rollout_board, played, ply);
+
+    // Map the evaluation to the expected result
+    return estimatedResult(rollout_board, played, ply);
+}
+
+template<class Geometry>
+BasicRolloutResult<Geometry> BasicMCTSNode<Geometry>::evaluate() const {
+    if(isTerminal()) return gameResult(board, {});
+    return estimatedResult(board, {});
 }
 
 
-double MCTS::ucb(MCTSNode* node){
+template<class Geometry>
+double BasicMCTS<Geometry>::meanValue(Node* node) const {
+    bool black_moved = !node->getAstraDoBoard().getTurn();
+    switch(node->getProven()){
+    case ProvenResult::BlackWin: return black_moved ? 1 : -1;
+    case ProvenResult::WhiteWin: return black_moved ? -1 : 1;
+    case ProvenResult::Draw: return 0;
+    default: break;
+    }
+    if(node->getNumVisits() == 0) return -1;
+    return black_moved ? node->getAvgWinSum() : -node->getAvgWinSum();
+}
+
+template<class Geometry>
+double BasicMCTS<Geometry>::ucb(Node* node){
     if(node->getNumVisits() == 0) return std::numeric_limits<double>::infinity();
     // Reverse average score if turn is white
-    return (node->getAstraDoBoard().getTurn() ? -node->getAvgWinSum() : node->getAvgWinSum()) +
-           sqrt(DEFAULT_C * log(node->getParent()->getNumVisits()) / node->getNumVisits());
+    double value = node->getAstraDoBoard().getTurn() ? -node->getAvgWinSum() : node->getAvgWinSum();
+    // Blend in AMAF statistics, their weight decays as the node gets more visits
+    if(useRave && node->getAmafVisits() > 0){
+        double amaf = node->getAstraDoBoard().getTurn() ? -node->getAvgAmafWinSum() : node->getAvgAmafWinSum();
+        double beta = sqrt(raveK / (3 * node->getNumVisits() + raveK));
+        value = (1 - beta) * value + beta * amaf;
+    }
+    return value + sqrt(explorationC * log(node->getParent()->getNumVisits()) / node->getNumVisits());
 }
 
-MCTS::MCTS(
-    AstraDoBoard initialBoard,
+template<class Geometry>
+BasicMCTS<Geometry>::BasicMCTS(
+    Board initialBoard,
     int iterations
-    ) : iterations(iterations){
-    root = new MCTSNode(initialBoard, nullptr, 100);
+    ) : iterations(iterations),
+    rng(std::random_device{}()){
+    root = new Node(initialBoard, nullptr, Geometry::NO_MOVE);
+    treeBytes = root->getMemoryUsage();
+    treeNodes = 1;
+}
+
+template<class Geometry>
+BasicMCTS<Geometry>::BasicMCTS(
+    Board initialBoard,
+    const SearchBudget& budget
+    ) : iterations(budget.nodes > 0 ? static_cast<int>(budget.nodes) : 10000),
+    timeLimitMs(budget.timeMs),
+    memoryLimit(budget.memoryBytes),
+    rng(std::random_device{}()){
+    // Only time is limited
+    if(budget.nodes <= 0 && budget.timeMs > 0) iterations = std::numeric_limits<int>::max();
+    root = new Node(initialBoard, nullptr, Geometry::NO_MOVE);
+    treeBytes = root->getMemoryUsage();
+    treeNodes = 1;
 }
 
 
-MCTS::~MCTS() {
+template<class Geometry>
+BasicMCTS<Geometry>::~BasicMCTS() {
     delete root;
 }
 
-void MCTS::run() {
-    srand(time(0));
-    for (int i = 0; i < iterations; ++i){
-        MCTSNode* node = select(root);
-        MCTSNode* rolloutNode;
-        // Node is visited less than threshold, do no expand node
-        // If the game has ended in the node, also do not expand
-        if(node->getNumVisits() < DEFAULT_MIN_VISITS || node->isTerminal()){
-            rolloutNode = node;
+template<class Geometry>
+void BasicMCTS<Geometry>::run() {
+    runStart = std::chrono::steady_clock::now();
+    lastCheckpoint = runStart;
+    lastInfo = runStart;
+    lastAnalysis = runStart;
+    iterationsDone = 0;
+    halvingMove = Geometry::NO_MOVE;
+    // A root solved as a leaf of an earlier search has no children to choose from, search it again
+    if(root->isProven() && root->getChildren().empty()) root->setProven(ProvenResult::Unknown);
+    instrumentation.begin();
+    if(rootPolicy == RootPolicy::SequentialHalving && timeLimitMs == 0){
+        runSequentialHalving();
+    }
+    else{
+        for (int i = 0; i < iterations; ++i){
+            // Exact result of the root is known, no need to search further
+            if(root->isProven()) break;
+            // Check the clock every few iterations
+            if((i & 63) == 0 && checkLimits()) break;
+            iterate(root);
         }
-        else{
-            expand(node);
-            rolloutNode = node->getChildren().empty() ? node : node->getChildren()[rand() % node->getChildren().size()];
+    }
+    runEnd = std::chrono::steady_clock::now();
+    instrumentation.end();
+    if(!checkpointPath.empty()) saveTree(checkpointPath);
+    if(analysisChannel) analysisChannel->publish(getAnalysis(analysisLines));
+    if(infoCallback) infoCallback(getInfo());
+}
+
+template<class Geometry>
+bool BasicMCTS<Geometry>::checkLimits(){
+    if(stopFlag && stopFlag->load(std::memory_order_relaxed)) return true;
+    if(timeLimitMs == 0 && checkpointPath.empty() && !infoCallback && !analysisChannel) return false;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(timeLimitMs > 0 && now - runStart >= std::chrono::milliseconds(timeLimitMs)) return true;
+    if(!checkpointPath.empty() && now - lastCheckpoint >= std::chrono::milliseconds(checkpointIntervalMs)){
+        saveTree(checkpointPath);
+        lastCheckpoint = now;
+    }
+    if(infoCallback && now - lastInfo >= std::chrono::milliseconds(infoIntervalMs)){
+        infoCallback(getInfo());
+        lastInfo = now;
+    }
+    if(analysisChannel && now - lastAnalysis >= std::chrono::milliseconds(analysisIntervalMs)){
+        analysisChannel->publish(getAnalysis(analysisLines));
+        lastAnalysis = now;
+    }
+    return false;
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::iterate(Node* node){
+    // Make room before the tree grows, no node of the previous iteration is still in use
+    if(memoryLimit > 0 && treeBytes > memoryLimit) collapseTree();
+    ++iterationsDone;
+    instrumentation.enter(SearchPhase::Select);
+    node = select(node);
+    instrumentation.reached(node);
+    instrumentation.enter(SearchPhase::Expand);
+    Node* rolloutNode;
+    // Node is about to be expanded, try to solve it first
+    // The root is left to its children, a move can only be chosen among them
+    if(useProofNumberSearch && node != root && node->getNumVisits() == minVisits && !node->isTerminal()){
+        solve(node);
+    }
+    // Node is visited less than threshold, do no expand node
+    // If the game has ended in the node, or the result is known, also do not expand
+    if(node->getNumVisits() < minVisits || node->isTerminal() || node->isProven()){
+        rolloutNode = node;
+    }
+    else{
+        expand(node);
+        rolloutNode = node->getChildren().empty() ? node : node->getChildren()[rng() % node->getChildren().size()];
+    }
+    instrumentation.enter(SearchPhase::Simulate);
+    RolloutResult result = simulate(rolloutNode);
+    instrumentation.rollout(result.plies);
+    instrumentation.enter(SearchPhase::Backpropagate);
+    backpropagate(rolloutNode, result);
+    instrumentation.leave();
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::runSequentialHalving(){
+    // Budget is split among the root moves, so they have to exist first
+    if(root->getChildren().empty()) expand(root);
+    std::vector<Node*> candidates(root->getChildren());
+    if(candidates.empty()) return;
+
+    int rounds = static_cast<int>(ceil(log2(static_cast<double>(candidates.size()))));
+    for(int round = 0; round < rounds && candidates.size() > 1; ++round){
+        // Every remaining move gets the same share of the round's budget
+        int per_move = std::max(1, static_cast<int>(iterations / (static_cast<long long>(rounds) * candidates.size())));
+        for(Node* child : candidates){
+            for(int j = 0; j < per_move && !child->isProven(); ++j){
+                if(iterationsDone >= iterations) break;
+                // Stopped early, the most visited move is played instead
+                if((iterationsDone & 63) == 0 && checkLimits()) return;
+                iterate(child);
+            }
+            // A winning move was found, no need to compare the rest
+            if(root->isProven()) return;
         }
-        double result = simulate(rolloutNode);
-        backpropagate(rolloutNode, result);
+        // Keep the better half
+        std::stable_sort(candidates.begin(), candidates.end(), [this](Node* a, Node* b) {
+            return meanValue(a) > meanValue(b);
+        });
+        candidates.resize((candidates.size() + 1) / 2);
     }
+    halvingMove = candidates[0]->getMove();
 }
 
-MCTSNode* MCTS::select(MCTSNode* node) {
+template<class Geometry>
+BasicMCTSNode<Geometry>* BasicMCTS<Geometry>::select(Node* node) {
     while(!node->getChildren().empty()) {
-        node = *max_element(node->getChildren().begin(), node->getChildren().end(), [this](MCTSNode* a, MCTSNode* b) {
-            return this->ucb(a) < this->ucb(b);
-        });
+        // Proven subtrees need no more visits, only pick among uncertain children
+        Node* best = nullptr;
+        double best_ucb = 0;
+        for(Node* child : node->getChildren()){
+            if(child->isProven()) continue;
+            double child_ucb = ucb(child);
+            if(!best || child_ucb > best_ucb){
+                best = child;
+                best_ucb = child_ucb;
+            }
+        }
+        if(!best) break;
+        node = best;
     }
     return node;
 }
 
-void MCTS::expand(MCTSNode* node){
+template<class Geometry>
+void BasicMCTS<Geometry>::expand(Node* node){
+    size_t before = node->getMemoryUsage();
     node->expand();
+    treeBytes += node->getMemoryUsage() - before;
+    for(Node* child : node->getChildren()) treeBytes += child->getMemoryUsage();
+    treeNodes += node->getChildren().size();
+}
+
+template<class Geometry>
+size_t BasicMCTS<Geometry>::collapsibleMemory(Node* node, int min_visits, long long& nodes) const {
+    size_t freed = 0;
+    for(Node* child : node->getChildren()){
+        if(child->getChildren().empty()) continue;
+        // Visits only decrease going down, so the first node at the threshold is the top of the subtree
+        if(child->getNumVisits() <= min_visits){
+            // The node keeps its own memory, apart from the list of children
+            freed += child->getChildren().capacity() * sizeof(Node*) + Node::ALLOCATION_OVERHEAD;
+            std::vector<Node*> stack(child->getChildren());
+            while(!stack.empty()){
+                Node* descendant = stack.back();
+                stack.pop_back();
+                freed += descendant->getMemoryUsage();
+                ++nodes;
+                stack.insert(stack.end(), descendant->getChildren().begin(), descendant->getChildren().end());
+            }
+        }
+        else{
+            freed += collapsibleMemory(child, min_visits, nodes);
+        }
+    }
+    return freed;
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::collapseBelow(Node* node, int min_visits){
+    for(Node* child : node->getChildren()){
+        if(child->getChildren().empty()) continue;
+        if(child->getNumVisits() <= min_visits) child->collapse();
+        else collapseBelow(child, min_visits);
+    }
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::collapseTree(){
+    size_t target = static_cast<size_t>(memoryLimit * COLLAPSE_TARGET);
+    // Raise the visit threshold until enough memory would be freed
+    // Children of the root are kept so that the move can still be chosen
+    int min_visits = minVisits;
+    size_t freed = 0;
+    long long nodes = 0;
+    while(true){
+        nodes = 0;
+        freed = collapsibleMemory(root, min_visits, nodes);
+        if(treeBytes - freed <= target || min_visits >= root->getNumVisits()) break;
+        min_visits *= 2;
+    }
+    collapseBelow(root, min_visits);
+    treeBytes -= freed;
+    treeNodes -= nodes;
 }
 
-double MCTS::simulate(MCTSNode* node){
-    return node->random_rollout();
+template<class Geometry>
+BasicRolloutResult<Geometry> BasicMCTS<Geometry>::simulate(Node* node){
+    if constexpr(Geometry::STANDARD){
+        if(rolloutType == RolloutType::Truncated) return node->truncated_rollout(rolloutPlies, rng);
+        if(rolloutType == RolloutType::Evaluation) return node->evaluate();
+    }
+    return node->random_rollout(rng);
 }
 
-void MCTS::backpropagate(MCTSNode* node, double score){
+template<class Geometry>
+void BasicMCTS<Geometry>::backpropagate(Node* node, const RolloutResult& result){
+    // Squares played below the current node, including the rollout
+    std::array<uint8_t, Geometry::CELLS> played = result.played;
+    // Proven results are passed upwards until a node cannot be settled
+    bool proving = true;
     while (node) {
-        node->update(score);
+        node->update(result);
+        if(useRave){
+            // Every child whose move was played later by the same side shares the result
+            uint8_t side = node->getAstraDoBoard().getTurn() ? 1 : 2;
+            for(Node* child : node->getChildren()){
+                if(child->getMove() < Geometry::CELLS && played[child->getMove()] == side) child->updateAmaf(result.win);
+            }
+            if(node->getMove() < Geometry::CELLS && node->getParent()){
+                played[node->getMove()] = node->getParent()->getAstraDoBoard().getTurn() ? 1 : 2;
+            }
+        }
+        if(proving){
+            node->updateProven();
+            proving = node->isProven();
+        }
         node = node->getParent();
     }
 }
 
-uint8_t MCTS::getBestMove() {
-    if(root->getAstraDoBoard().getMoves().empty()) return 54;
+template<class Geometry>
+void BasicMCTS<Geometry>::solve(Node* node){
+    // Proof-number search only knows the standard board
+    if constexpr(Geometry::STANDARD){
+        const Board& board = node->getAstraDoBoard();
+        std::pair<int, int> piece_count = board.getPieceCount();
+        if(Geometry::CELLS - piece_count.first - piece_count.second > PNS_MAX_EMPTIES) return;
+
+        if(!pns) pns = std::make_unique<ProofNumberSearch>(1 << 16);
+        bool turn = board.getTurn();
+        ProofResult result = pns->solve(board, turn, PNS_NODE_BUDGET);
+        if(result == ProofResult::Proven){
+            node->setProven(turn ? ProvenResult::BlackWin : ProvenResult::WhiteWin);
+            return;
+        }
+        if(result == ProofResult::Unknown) return;
+
+        // Side to move cannot win, find out whether the opponent wins
+        result = pns->solve(board, !turn, PNS_NODE_BUDGET);
+        if(result == ProofResult::Proven) node->setProven(turn ? ProvenResult::WhiteWin : ProvenResult::BlackWin);
+        else if(result == ProofResult::Disproven) node->setProven(ProvenResult::Draw);
+    }
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setRollout(RolloutType type, int plies){
+    rolloutType = type;
+    rolloutPlies = plies;
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setRave(bool enabled, double k){
+    useRave = enabled;
+    if(k > 0) raveK = k;
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setProofNumberSearch(bool enabled) { useProofNumberSearch = enabled; }
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setRootPolicy(RootPolicy policy) { rootPolicy = policy; }
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setExploration(double c) { explorationC = c; }
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setMinVisits(int visits) { minVisits = std::max(1, visits); }
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setSeed(uint32_t seed) { rng.seed(seed); }
+
+void MCTSConfig::apply(MCTS& mcts) const {
+    mcts.setExploration(c);
+    mcts.setMinVisits(minVisits);
+    mcts.setRollout(rollout, rolloutPlies);
+    mcts.setRootPolicy(rootPolicy);
+    mcts.setRave(raveK > 0, raveK);
+    mcts.setProofNumberSearch(proofNumberSearch);
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setMemoryLimit(size_t bytes) { memoryLimit = bytes; }
+
+template<class Geometry>
+void BasicMCTS<Geometry>::trimTree(){
+    if(memoryLimit > 0 && treeBytes > memoryLimit) collapseTree();
+}
+
+template<class Geometry>
+size_t BasicMCTS<Geometry>::getMemoryUsage() const { return treeBytes; }
+
+template<class Geometry>
+long long BasicMCTS<Geometry>::getTreeSize() const { return treeNodes; }
+
+template<class Geometry>
+BasicMCTSNode<Geometry>* BasicMCTS<Geometry>::getRoot() const { return root; }
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setStopFlag(const std::atomic<bool>* flag) { stopFlag = flag; }
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setInfoCallback(std::function<void(const MCTSInfo&)> callback, int interval_ms){
+    infoCallback = std::move(callback);
+    infoIntervalMs = interval_ms;
+}
+
+template<class Geometry>
+MCTSInfo BasicMCTS<Geometry>::getInfo() const {
+    MCTSInfo info;
+    info.bestMove = Geometry::NO_MOVE;
+    info.iterations = iterationsDone;
+    info.timeMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - runStart).count());
+    info.treeNodes = treeNodes;
+    for(Node* child : root->getChildren()){
+        if(child->getNumVisits() > info.bestVisits){
+            info.bestMove = child->getMove();
+            info.bestVisits = child->getNumVisits();
+            info.value = meanValue(child);
+        }
+    }
+    return info;
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setAnalysis(AnalysisChannel* channel, int lines, int interval_ms){
+    analysisChannel = channel;
+    analysisLines = lines;
+    analysisIntervalMs = interval_ms;
+}
+
+template<class Geometry>
+AnalysisSnapshot BasicMCTS<Geometry>::getAnalysis(int lines) const {
+    AnalysisSnapshot snapshot;
+    snapshot.iterations = iterationsDone;
+    snapshot.timeMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - runStart).count());
+    snapshot.treeNodes = treeNodes;
+
+    // Same order as getBestMove: visits first, the better average on a tie
+    std::vector<Node*> children(root->getChildren());
+    std::stable_sort(children.begin(), children.end(), [this](Node* a, Node* b) {
+        if(a->getNumVisits() != b->getNumVisits()) return a->getNumVisits() > b->getNumVisits();
+        return meanValue(a) > meanValue(b);
+    });
+    bool black = root->getAstraDoBoard().getTurn();
+    snapshot.lineCount = std::min({lines, ANALYSIS_MAX_LINES, static_cast<int>(children.size())});
+    for(int i = 0; i < snapshot.lineCount; ++i){
+        Node* child = children[i];
+        AnalysisLine& line = snapshot.lines[i];
+        line.move = child->getMove();
+        line.visits = child->getNumVisits();
+        line.winRate = (meanValue(child) + 1) / 2;
+        if(child->getNumVisits() > 0) line.scoreDiff = black ? child->getAvgScore() : -child->getAvgScore();
+        line.proven = child->getProven();
+        // Follow the most visited child
+        for(Node* node = child; node && line.pvLength < ANALYSIS_MAX_PV; ){
+            line.pv[line.pvLength++] = node->getMove() >= Geometry::CELLS ? Geometry::PASS : node->getMove();
+            Node* next = nullptr;
+            for(Node* grandchild : node->getChildren()){
+                if(grandchild->getNumVisits() > 0 && (!next || grandchild->getNumVisits() > next->getNumVisits())) next = grandchild;
+            }
+            node = next;
+        }
+    }
+    return snapshot;
+}
+
+template<class Geometry>
+SearchStats BasicMCTS<Geometry>::getStats() const {
+    SearchStats stats;
+    stats.iterations = iterationsDone;
+    stats.seconds = std::chrono::duration<double>(runEnd - runStart).count();
+    stats.treeNodes = treeNodes;
+    stats.memoryBytes = treeBytes;
+    instrumentation.fill(stats);
+    return stats;
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setCheckpoint(const std::string& path, int interval_ms){
+    checkpointPath = path;
+    checkpointIntervalMs = interval_ms;
+}
+
+template<class Geometry>
+bool BasicMCTS<Geometry>::saveTree(const std::string& path) const {
+    // Header holds the root position of the standard board only
+    if constexpr(!Geometry::STANDARD) return false;
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if(!file) return false;
+
+        TreeHeader header{};
+        std::memcpy(header.magic, TREE_MAGIC, 4);
+        header.version = TREE_VERSION;
+        const Board& board = root->getAstraDoBoard();
+        header.black = board.getBlackPieces().word(0);
+        header.white = board.getWhitePieces().word(0);
+        header.turn = board.getTurn();
+        header.stale = board.getStale();
+        header.nodeCount = static_cast<uint64_t>(treeNodes);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Streaming pre-order walk, only the path to the current node is kept
+        std::vector<Node*> stack{root};
+        uint64_t written = 0;
+        while(!stack.empty()){
+            Node* node = stack.back();
+            stack.pop_back();
+            MCTSNodeStatistics statistics = node->getStatistics();
+            NodeRecord record{};
+            record.numVisits = statistics.numVisits;
+            record.amafVisits = statistics.amafVisits;
+            record.winSum = statistics.winSum;
+            record.scoreSum = statistics.scoreSum;
+            record.amafWinSum = statistics.amafWinSum;
+            record.move = node->getMove();
+            record.proven = static_cast<uint8_t>(statistics.proven);
+            record.numChildren = static_cast<uint8_t>(node->getChildren().size());
+            file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            ++written;
+            // Pushed in reverse so that children are written in order
+            stack.insert(stack.end(), node->getChildren().rbegin(), node->getChildren().rend());
+        }
+        if(written != header.nodeCount){
+            // Node count of the header is patched if the accounting was off
+            file.seekp(offsetof(TreeHeader, nodeCount));
+            file.write(reinterpret_cast<const char*>(&written), sizeof(written));
+        }
+        file.flush();
+        if(!file) return false;
+    }
+    if(std::rename(temp_path.c_str(), path.c_str()) != 0){
+        // Renaming over an existing file fails on some systems
+        std::remove(path.c_str());
+        if(std::rename(temp_path.c_str(), path.c_str()) != 0) return false;
+    }
+    return true;
+}
+
+template<class Geometry>
+bool BasicMCTS<Geometry>::loadTree(const std::string& path){
+    if constexpr(!Geometry::STANDARD) return false;
+    MappedFile file;
+    if(!file.open(path) || file.size() < sizeof(TreeHeader)) return false;
+    TreeHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if(std::memcmp(header.magic, TREE_MAGIC, 4) != 0 || header.version != TREE_VERSION) return false;
+    if(header.nodeCount == 0 || (file.size() - sizeof(header)) / sizeof(NodeRecord) < header.nodeCount) return false;
+    if(header.black & header.white) return false;
+    // Cells past the board, the header only holds boards of up to 64 cells
+    constexpr uint64_t CELL_MASK = Geometry::CELLS >= 64 ? ~uint64_t(0) : (uint64_t(1) << (Geometry::CELLS % 64)) - 1;
+    if((header.black | header.white) & ~CELL_MASK) return false;
+
+    typename Board::Bits black_pieces, white_pieces;
+    black_pieces.setWord(0, header.black);
+    white_pieces.setWord(0, header.white);
+    Board board(black_pieces, white_pieces, header.turn != 0);
+    board.setStale(header.stale != 0);
+
+    const uint8_t* records = file.data() + sizeof(header);
+    auto readRecord = [records](uint64_t index) {
+        NodeRecord record;
+        std::memcpy(&record, records + index * sizeof(NodeRecord), sizeof(record));
+        return record;
+    };
+    auto toStatistics = [](const NodeRecord& record) {
+        MCTSNodeStatistics statistics;
+        statistics.numVisits = record.numVisits;
+        statistics.winSum = record.winSum;
+        statistics.scoreSum = record.scoreSum;
+        statistics.amafVisits = record.amafVisits;
+        statistics.amafWinSum = record.amafWinSum;
+        statistics.proven = static_cast<ProvenResult>(std::min<uint8_t>(record.proven, 3));
+        return statistics;
+    };
+
+    std::unique_ptr<Node> new_root(new Node(board, nullptr, Geometry::NO_MOVE));
+    NodeRecord record = readRecord(0);
+    new_root->setStatistics(toStatistics(record));
+    // Nodes whose children are still being read, with the number of children left
+    std::vector<std::pair<Node*, int>> pending;
+    if(record.numChildren > 0) pending.emplace_back(new_root.get(), record.numChildren);
+    for(uint64_t i = 1; i < header.nodeCount; ++i){
+        if(pending.empty()) return false;
+        Node* parent = pending.back().first;
+        if(--pending.back().second == 0) pending.pop_back();
+
+        record = readRecord(i);
+        // Moves are replayed, so they have to be legal in the parent position
+        const std::vector<uint8_t>& moves = parent->getAstraDoBoard().getMoves();
+        bool legal = moves.empty() ? record.move >= Geometry::CELLS : std::find(moves.begin(), moves.end(), record.move) != moves.end();
+        if(!legal || parent->isTerminal()) return false;
+
+        Node* child = parent->addChild(record.move);
+        child->setStatistics(toStatistics(record));
+        if(record.numChildren > 0) pending.emplace_back(child, record.numChildren);
+    }
+    if(!pending.empty()) return false;
+
+    delete root;
+    root = new_root.release();
+    // Recount the memory of the new tree
+    treeBytes = 0;
+    treeNodes = 0;
+    std::vector<Node*> stack{root};
+    while(!stack.empty()){
+        Node* node = stack.back();
+        stack.pop_back();
+        treeBytes += node->getMemoryUsage();
+        ++treeNodes;
+        stack.insert(stack.end(), node->getChildren().begin(), node->getChildren().end());
+    }
+    return true;
+}
+
+template<class Geometry>
+double BasicMCTS<Geometry>::getSimpleRegret() const { return simpleRegret; }
+
+template<class Geometry>
+long long BasicMCTS<Geometry>::getNodeCount() const { return iterationsDone; }
+
+template<class Geometry>
+uint8_t BasicMCTS<Geometry>::getBestMove() {
+    simpleRegret = 0;
+    if(root->getAstraDoBoard().getMoves().empty()) return Geometry::PASS;
     else if(root->getAstraDoBoard().getMoves().size() == 1) return root->getAstraDoBoard().getMoves()[0];
     run();
-    // printTree();
-    MCTSNode* node = *std::max_element(root->getChildren().begin(), root->getChildren().end(), [this](MCTSNode* a, MCTSNode* b) {
-        return this->ucb(a) < this->ucb(b);
-    });
-    // std::cout << "UCB" << std::endl;
-    // for(MCTSNode* child: root->getChildren()){
-    //     std::cout << static_cast<int>(child->getMove()) << ": " << ucb(child) << std::endl;
-    // }
+    return chooseMove();
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::setBudget(const SearchBudget& budget){
+    iterations = budget.nodes > 0 ? static_cast<int>(budget.nodes) : 10000;
+    timeLimitMs = budget.timeMs;
+    // Only time is limited
+    if(budget.nodes <= 0 && budget.timeMs > 0) iterations = std::numeric_limits<int>::max();
+}
+
+template<class Geometry>
+void BasicMCTS<Geometry>::advance(uint8_t move){
+    Node* child = root->detachChild(move);
+    if(!child){
+        // Move was never searched, start a new tree
+        Board board(root->getAstraDoBoard());
+        board.makeMove(move);
+        child = new Node(board, nullptr, Geometry::NO_MOVE);
+    }
+    delete root;
+    root = child;
+    // Count what is left of the tree
+    treeBytes = 0;
+    treeNodes = 0;
+    std::vector<Node*> stack{root};
+    while(!stack.empty()){
+        Node* node = stack.back();
+        stack.pop_back();
+        treeBytes += node->getMemoryUsage();
+        ++treeNodes;
+        stack.insert(stack.end(), node->getChildren().begin(), node->getChildren().end());
+    }
+}
+
+template<class Geometry>
+uint8_t BasicMCTS<Geometry>::chooseMove() {
+    simpleRegret = 0;
+    if(root->getAstraDoBoard().getMoves().empty()) return Geometry::PASS;
+    // Search was too short to expand the root
+    if(root->getChildren().empty()) return root->getAstraDoBoard().getMoves()[0];
+    ProvenResult win = root->getAstraDoBoard().getTurn() ? ProvenResult::BlackWin : ProvenResult::WhiteWin;
+    ProvenResult loss = root->getAstraDoBoard().getTurn() ? ProvenResult::WhiteWin : ProvenResult::BlackWin;
+    Node* node = nullptr;
+    // Proven draws stop gaining visits, so they are compared by their exact value below
+    Node* draw = nullptr;
+    double best_value = -1;
+    for(Node* child : root->getChildren()){
+        // Play a proven win straight away
+        if(child->getProven() == win) return child->getMove();
+        if(child->getNumVisits() > 0 || child->isProven()) best_value = std::max(best_value, meanValue(child));
+        // Avoid proven losses unless every move loses
+        if(child->getProven() == loss) continue;
+        if(child->getProven() == ProvenResult::Draw && !draw) draw = child;
+        if(halvingMove != Geometry::NO_MOVE){
+            if(child->getMove() == halvingMove) node = child;
+        }
+        // Most visited move, exploration bonus only matters while searching
+        else if(!node || child->getNumVisits() > node->getNumVisits() ||
+                 (child->getNumVisits() == node->getNumVisits() && meanValue(child) > meanValue(node))){
+            node = child;
+        }
+    }
+    if(!node) node = root->getChildren()[0];
+    // A certain draw beats a move that is expected to lose
+    if(draw && node != draw && meanValue(node) < meanValue(draw)) node = draw;
+    simpleRegret = std::max(0.0, best_value - meanValue(node));
     return node->getMove();
 }
 
+template class BasicMCTSNode<AstraDoGeometry>;
+template class BasicMCTSNode<HexGeometry<4>>;
+template class BasicMCTSNode<HexGeometry<5>>;
+template class BasicMCTSNode<HexGeometry<6>>;
+template class BasicMCTS<AstraDoGeometry>;
+template class BasicMCTS<HexGeometry<4>>;
+template class BasicMCTS<HexGeometry<5>>;
+template class BasicMCTS<HexGeometry<6>>;
@@ -2,49 +2,148 @@
 #define MCTS_H
 
 #include "board.h"
+#include "search.h"
+#include "pns.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "instrumentation.h"
+#include "analysis.h"
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <random>
+#include <string>
 #include <vector>
 
+// Result of a simulation, from black's point of view
+template<class Geometry>
+struct BasicRolloutResult {
+    // Piece difference (black - white), current difference if the rollout was cut short
+    double score;
+    // +1 if black wins, -1 if white wins, 0 if draw, expected value if cut short
+    double win;
+    // Side that played each square during the rollout, 1 for black, 2 for white, 0 if none
+    std::array<uint8_t, Geometry::CELLS> played{};
+    // Plies played by the rollout, passes included
+    int plies = 0;
+};
+
+using RolloutResult = BasicRolloutResult<AstraDoGeometry>;
+
+// Statistics of a node, as stored in a checkpoint
+struct MCTSNodeStatistics {
+    int numVisits = 0;
+    double winSum = 0;
+    double scoreSum = 0;
+    int amafVisits = 0;
+    double amafWinSum = 0;
+    ProvenResult proven = ProvenResult::Unknown;
+};
+
+// Progress of a running search
+struct MCTSInfo {
+    long long iterations = 0;
+    int timeMs = 0;
+    // Most visited root move so far, NO_MOVE of the geometry if the root is not expanded
+    uint8_t bestMove = AstraDoGeometry::NO_MOVE;
+    int bestVisits = 0;
+    // Average result of the best move for the side to move, from -1 to 1
+    double value = 0;
+    long long treeNodes = 0;
+};
+
+// Random rollouts play until the game ends
+// Truncated rollouts stop after a few plies and evaluate the position
+// Evaluation skips the rollout and evaluates the node itself
+// Positions are evaluated by the loaded network, or by AstraDoEvaluator if there is none
+enum class RolloutType { Random, Truncated, Evaluation };
+
+// UCB spends the root visits like any other node
+// Sequential halving splits a fixed budget evenly and drops the worse half of the root moves each round
+enum class RootPolicy { UCB, SequentialHalving };
+
 // MCTS Tree Node
-class MCTSNode {
+template<class Geometry>
+class BasicMCTSNode {
+public:
+    using Board = BasicBoard<Geometry>;
+    using Node = BasicMCTSNode<Geometry>;
+    using RolloutResult = BasicRolloutResult<Geometry>;
+
 private:
-    AstraDoBoard board;
-    MCTSNode* parent;
-    std::vector<MCTSNode*> children;
+    Board board;
+    Node* parent;
+    std::vector<Node*> children;
     uint8_t move;           // Move that leads to this position
 
     int numVisits = 0;
     double winSum = 0;      // +1 if black wins, -1 if white wins, 0 if draw
     double scoreSum = 0.0;
 
+    // All-moves-as-first statistics of the move leading to this node
+    int amafVisits = 0;
+    double amafWinSum = 0;
+
+    // Exact result of the position if known, regardless of rollouts
+    ProvenResult proven = ProvenResult::Unknown;
+
+    // Rollouts look for a decided result by stable pieces every few plies
+    static const int STABILITY_CHECK_PLIES = 4;
+
+    // Truncated rollouts play at least this many plies before stopping at a quiet position
+    static const int MIN_TRUNCATED_PLIES = 2;
+
 public:
-    MCTSNode(
-        AstraDoBoard board,
-        MCTSNode* parent,
+    // Bookkeeping added by the allocator to every heap block
+    static const size_t ALLOCATION_OVERHEAD = 16;
+
+    BasicMCTSNode(
+        Board board,
+        Node* parent,
         uint8_t move
         );
-    ~MCTSNode();
+    ~BasicMCTSNode();
 
     // Node Operations
     void expand();
 
-    double random_rollout() const;
+    // Delete all children, the node keeps its statistics and becomes a leaf again
+    void collapse();
+
+    // Add a single child after the move (>= CELLS for a pass), the move is not checked
+    Node* addChild(uint8_t move);
 
-    void update(double score);
+    // Take the child after the move (>= CELLS for a pass) out of the tree and make it a root
+    // Returns nullptr if the node has no such child
+    Node* detachChild(uint8_t move);
 
+    RolloutResult random_rollout(std::mt19937& rng) const;
+
+    // Play at most max_plies random moves, stopping early at a quiet position
+    RolloutResult truncated_rollout(int max_plies, std::mt19937& rng) const;
+
+    // Expected result of the node without playing any moves
+    RolloutResult evaluate() const;
+
+    void update(const RolloutResult& result);
+
+    void updateAmaf(double win);
+
+    // Try to settle the exact result from the game end or the children
+    // Returns true if the node has just been proven
+    bool updateProven();
 
     // Getters
-    const AstraDoBoard& getAstraDoBoard() const;
+    const Board& getAstraDoBoard() const;
 
-    MCTSNode* getParent() const;
+    Node* getParent() const;
 
-    const std::vector<MCTSNode*>& getChildren() const;
+    const std::vector<Node*>& getChildren() const;
 
     uint8_t getMove() const;
 
@@ -56,50 +155,287 @@ public:
 
     int getNumVisits() const;
 
+    double getAvgAmafWinSum() const;
+
+    int getAmafVisits() const;
+
+    ProvenResult getProven() const;
+
+    // Approximate heap memory of the node itself, without its children
+    size_t getMemoryUsage() const;
+
+    void setProven(ProvenResult result);
+
+    MCTSNodeStatistics getStatistics() const;
+
+    void setStatistics(const MCTSNodeStatistics& statistics);
+
+    bool isProven() const;
+
 };
 
 // Monte-Carlo Tree Search Algorithm
-class MCTS{
+// Evaluation, truncated rollouts, proof-number search and checkpoints need the standard geometry,
+// on other boards rollouts are random and the tree is searched without solving
+template<class Geometry>
+class BasicMCTS : public SearchEngine {
+public:
+    using Board = BasicBoard<Geometry>;
+    using Node = BasicMCTSNode<Geometry>;
+    using RolloutResult = BasicRolloutResult<Geometry>;
+
 private:
     // Root node of MCTS
-    MCTSNode* root;
+    Node* root;
     int iterations;
+    // Thinking time in milliseconds, 0 if only iterations are limited
+    int timeLimitMs = 0;
+    // Iterations performed by the last run
+    long long iterationsDone = 0;
 
-    // Default minimum iterations before a node will be expanded
-    const int DEFAULT_MIN_VISITS = 5;
+    // Memory cap of the tree in bytes, 0 if unlimited
+    size_t memoryLimit = 0;
+    // Approximate memory and number of nodes of the tree
+    size_t treeBytes = 0;
+    long long treeNodes = 0;
+    // Once the cap is reached the tree is cut down to this fraction of it
+    const double COLLAPSE_TARGET = 0.75;
 
-    // Default hyperparameter c of MCTS (for balancing search depth and width)
-    // Node that the value will be square-rooted in use
-    const int DEFAULT_C = 2;
+    // Tree is saved to this file every checkpointIntervalMs while running, empty if never
+    std::string checkpointPath;
+    int checkpointIntervalMs = 0;
+
+    // Search ends as soon as the flag is set, it may be set from another thread
+    const std::atomic<bool>* stopFlag = nullptr;
+    std::function<void(const MCTSInfo&)> infoCallback;
+    int infoIntervalMs = 0;
+    // Snapshots of the best root moves are published here while running, nullptr if not
+    AnalysisChannel* analysisChannel = nullptr;
+    int analysisLines = 1;
+    int analysisIntervalMs = 0;
+
+    std::chrono::steady_clock::time_point runStart;
+    std::chrono::steady_clock::time_point lastCheckpoint;
+    std::chrono::steady_clock::time_point lastInfo;
+    std::chrono::steady_clock::time_point lastAnalysis;
+    std::chrono::steady_clock::time_point runEnd;
+
+    // Phase timing and tree shape statistics, NullInstrumentation unless ASTRADO_INSTRUMENTATION is defined
+    MCTSInstrumentation instrumentation;
+
+    // Hyperparameters, DEFAULT_C and DEFAULT_MIN_VISITS unless changed
+    double explorationC = DEFAULT_C;
+    int minVisits = DEFAULT_MIN_VISITS;
+
+    // Random moves of rollouts and expansion, every search has its own generator
+    std::mt19937 rng;
+
+    // Nodes with at most this many empty squares are handed to proof-number search
+    const int PNS_MAX_EMPTIES = 10;
+    // Node budget of each proof-number search
+    const int PNS_NODE_BUDGET = 2000;
+
+    bool useProofNumberSearch = true;
+
+    // Equivalence parameter of RAVE, the number of visits where
+    // tree statistics and AMAF statistics are weighted about equally
+    // Flips make the value of a move depend on move order, so AMAF only helps with a small weight
+    const double DEFAULT_RAVE_K = 10;
+
+    bool useRave = false;
+    double raveK = DEFAULT_RAVE_K;
+
+    RolloutType rolloutType = RolloutType::Random;
+    int rolloutPlies = DEFAULT_ROLLOUT_PLIES;
+
+    RootPolicy rootPolicy = RootPolicy::UCB;
+    // Move left after the last round of sequential halving, NO_MOVE if not used
+    uint8_t halvingMove = Geometry::NO_MOVE;
+    // Estimated simple regret of the last chosen move
+    double simpleRegret = 0;
+    // Created on first use, the table is shared by all solved nodes
+    std::unique_ptr<ProofNumberSearch> pns;
 
-    double ucb(MCTSNode* node);
+    double ucb(Node* node);
+
+    // Average result of a node from the side that moved into it, proven results count fully
+    double meanValue(Node* node) const;
+
+    // One iteration of selection, expansion, simulation and backpropagation below the node
+    void iterate(Node* node);
+
+    // Sequential halving over the root children, needs an iteration budget
+    void runSequentialHalving();
+
+    // Called every few iterations, handles the clock, stop flag, checkpoints and info
+    // Returns true if the search has to end
+    bool checkLimits();
+
+    // Collapse the least visited subtrees until the tree fits in the target memory
+    void collapseTree();
+
+    // Memory freed by collapsing every subtree whose root has at most min_visits visits
+    size_t collapsibleMemory(Node* node, int min_visits, long long& nodes) const;
+
+    void collapseBelow(Node* node, int min_visits);
+
+    // Try to settle the exact result of an endgame node with proof-number search
+    void solve(Node* node);
 
 public:
-    MCTS(
-        AstraDoBoard initialBoard,
+    BasicMCTS(
+        Board initialBoard,
         int iterations = 10000
         );
 
-    ~MCTS();
+    // Initialize with a generic search budget
+    // If only a time limit is given, iterations are unlimited
+    BasicMCTS(
+        Board initialBoard,
+        const SearchBudget& budget
+        );
+
+    ~BasicMCTS();
 
     // Function that runs the algorithm
     void run();
 
     // Procedure of MCTS
     // Select which node to visit in the current iteration
-    MCTSNode* select(MCTSNode* node);
+    Node* select(Node* node);
 
     // Expand the node that are visiting
-    void expand(MCTSNode* node);
+    void expand(Node* node);
 
     // Perform rollouts
-    double simulate(MCTSNode* node);
+    RolloutResult simulate(Node* node);
 
     // Update scores from bottom to top
-    void backpropagate(MCTSNode* node, double score);
+    void backpropagate(Node* node, const RolloutResult& result);
+
+    // Default minimum iterations before a node will be expanded
+    static constexpr int DEFAULT_MIN_VISITS = 5;
+
+    // Default hyperparameter c of MCTS (for balancing search depth and width)
+    // Node that the value will be square-rooted in use
+    static constexpr double DEFAULT_C = 2;
+
+    // Default number of plies of a truncated rollout
+    static const int DEFAULT_ROLLOUT_PLIES = 8;
+
+    // Exploration constant c of UCB
+    void setExploration(double c);
+
+    // Visits a node needs before it is expanded
+    void setMinVisits(int visits);
+
+    // Seed the random generator, for reproducible searches
+    void setSeed(uint32_t seed);
+
+    // Choose the rollout policy, plies are only used by truncated rollouts
+    void setRollout(RolloutType type, int plies = DEFAULT_ROLLOUT_PLIES);
+
+    // Enable or disable RAVE, k is the equivalence parameter (0 keeps the current value)
+    void setRave(bool enabled, double k = 0);
+
+    // Enable or disable proof-number search on endgame nodes
+    void setProofNumberSearch(bool enabled);
+
+    // Choose how visits are spent at the root
+    // Sequential halving falls back to UCB when only time is limited
+    void setRootPolicy(RootPolicy policy);
+
+    // Best average result among root moves minus that of the chosen move, after getBestMove
+    double getSimpleRegret() const;
+
+    // Cap the memory of the tree, 0 for no limit
+    // When the cap is reached the least visited subtrees are collapsed back into leaves
+    void setMemoryLimit(size_t bytes);
+
+    // Collapse the tree down to the memory cap now instead of during the next run
+    void trimTree();
+
+    // Approximate memory of the tree in bytes
+    size_t getMemoryUsage() const;
+
+    // Number of nodes in the tree
+    long long getTreeSize() const;
+
+    Node* getRoot() const;
+
+    // Write the whole tree to a binary file in one pass
+    // The file is written next to the path first and then renamed, an old checkpoint survives a crash
+    bool saveTree(const std::string& path) const;
+
+    // Replace the tree, and the root position, by one saved with saveTree
+    // The file is memory-mapped; the tree is kept unchanged if the file is invalid
+    bool loadTree(const std::string& path);
+
+    // Save the tree every interval while running, and when the run ends
+    void setCheckpoint(const std::string& path, int interval_ms);
+
+    // Stop the search once the flag becomes true, nullptr to remove
+    void setStopFlag(const std::atomic<bool>* flag) override;
+
+    // Report progress every interval while running, on the searching thread
+    void setInfoCallback(std::function<void(const MCTSInfo&)> callback, int interval_ms);
+
+    // Current progress of the search
+    MCTSInfo getInfo() const;
+
+    // Publish the best root moves to the channel every interval while running, and when the run ends
+    // The channel has to outlive the search, nullptr to stop publishing
+    void setAnalysis(AnalysisChannel* channel, int lines, int interval_ms);
+
+    // Best root moves of the current tree, at most ANALYSIS_MAX_LINES
+    // Other threads read the published snapshots instead, the tree changes under them
+    AnalysisSnapshot getAnalysis(int lines) const;
+
+    // Summary of the last run, phase times and tree shape need ASTRADO_INSTRUMENTATION
+    SearchStats getStats() const;
 
     // Interface to get the best move by MCTS in the current position
-    uint8_t getBestMove();
+    uint8_t getBestMove() override;
+
+    // Best move of the tree as it is, without searching
+    uint8_t chooseMove();
+
+    // Limits of the following runs, the memory limit is kept
+    void setBudget(const SearchBudget& budget);
+
+    // Play a move at the root and keep the subtree below it, the move is not checked
+    // Statistics of the new root carry over to the next search
+    void advance(uint8_t move);
+
+    long long getNodeCount() const override;
+};
+
+// Tree and search of the board that is played
+using MCTSNode = BasicMCTSNode<AstraDoGeometry>;
+using MCTS = BasicMCTS<AstraDoGeometry>;
+
+// Geometries compiled into mcts.cpp
+extern template class BasicMCTSNode<AstraDoGeometry>;
+extern template class BasicMCTSNode<HexGeometry<4>>;
+extern template class BasicMCTSNode<HexGeometry<5>>;
+extern template class BasicMCTSNode<HexGeometry<6>>;
+extern template class BasicMCTS<AstraDoGeometry>;
+extern template class BasicMCTS<HexGeometry<4>>;
+extern template class BasicMCTS<HexGeometry<5>>;
+extern template class BasicMCTS<HexGeometry<6>>;
+
+// Search settings that can be chosen at runtime, for tuning and engine matches
+struct MCTSConfig {
+    double c = MCTS::DEFAULT_C;
+    int minVisits = MCTS::DEFAULT_MIN_VISITS;
+    RolloutType rollout = RolloutType::Random;
+    int rolloutPlies = MCTS::DEFAULT_ROLLOUT_PLIES;
+    RootPolicy rootPolicy = RootPolicy::UCB;
+    // RAVE weight k, 0 leaves RAVE off
+    double raveK = 0;
+    bool proofNumberSearch = true;
+
+    void apply(MCTS& mcts) const;
 };
 
 #endif // MCTS_H
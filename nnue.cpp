@@ -0,0 +1,252 @@
+#include "nnue.h"
+#include "board.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+// Every x86-64 CPU has SSE2, so builds without ASTRADO_NATIVE_ARCH still get vector code
+#define ASTRADO_SSE2
+#include <emmintrin.h>
+#endif
+
+static_assert(NNUE_HIDDEN % 32 == 0, "SIMD code works on blocks of 32 hidden units");
+
+namespace {
+// File layout, in native byte order, the astrado.nnue of the repository is little-endian:
+// "ADNN", version, NNUE_HIDDEN, NNUE_HIDDEN2 as uint32
+// first layer weights int16 [108][NNUE_HIDDEN], biases int16 [NNUE_HIDDEN]
+// second layer weights int8 [NNUE_HIDDEN2][2 * NNUE_HIDDEN], biases int32 [NNUE_HIDDEN2]
+// output weights int8 [NNUE_HIDDEN2], bias int32
+const char FILE_MAGIC[4] = {'A', 'D', 'N', 'N'};
+const uint32_t FILE_VERSION = 1;
+
+// Bumped on every load so boards notice their accumulator is out of date
+uint32_t next_generation = 1;
+
+template <typename T>
+bool readValues(std::ifstream& file, T* data, size_t count){
+    file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+    return static_cast<bool>(file);
+}
+
+// Feature of a piece as seen by one side, own pieces come first
+inline int featureIndex(uint8_t square, bool own){
+    return own ? square : 54 + square;
+}
+}
+
+std::unique_ptr<AstraDoNetwork> AstraDoNetwork::current;
+
+bool AstraDoNetwork::load(const std::string& path){
+    std::ifstream file(path, std::ios::binary);
+    if(!file) return false;
+
+    char magic[4];
+    uint32_t header[3];
+    if(!readValues(file, magic, 4) || std::memcmp(magic, FILE_MAGIC, 4) != 0) return false;
+    if(!readValues(file, header, 3)) return false;
+    if(header[0] != FILE_VERSION || header[1] != NNUE_HIDDEN || header[2] != NNUE_HIDDEN2) return false;
+
+    std::unique_ptr<AstraDoNetwork> network(new AstraDoNetwork());
+    network->ftWeights.resize(108 * NNUE_HIDDEN);
+    if(!readValues(file, network->ftWeights.data(), network->ftWeights.size())) return false;
+    if(!readValues(file, network->ftBias.data(), NNUE_HIDDEN)) return false;
+    for(std::array<int8_t, 2 * NNUE_HIDDEN>& row : network->l2Weights){
+        if(!readValues(file, row.data(), row.size())) return false;
+    }
+    if(!readValues(file, network->l2Bias.data(), NNUE_HIDDEN2)) return false;
+    if(!readValues(file, network->outWeights.data(), NNUE_HIDDEN2)) return false;
+    if(!readValues(file, &network->outBias, 1)) return false;
+
+    network->generation = next_generation++;
+    current = std::move(network);
+    return true;
+}
+
+bool AstraDoNetwork::loadDefault(const std::string& argv0, const std::string& path){
+    if(!path.empty()) return load(path);
+    size_t slash = argv0.find_last_of("/\\");
+    return load((slash == std::string::npos ? std::string() : argv0.substr(0, slash + 1)) + "astrado.nnue");
+}
+
+void AstraDoNetwork::unload(){
+    current.reset();
+}
+
+const AstraDoNetwork* AstraDoNetwork::active(){
+    return current.get();
+}
+
+uint32_t AstraDoNetwork::getGeneration() const {
+    return generation;
+}
+
+void AstraDoNetwork::addFeature(std::array<int16_t, NNUE_HIDDEN>& values, int feature) const {
+    const int16_t* weights = &ftWeights[feature * NNUE_HIDDEN];
+#if defined(__AVX2__)
+    for(int i = 0; i < NNUE_HIDDEN; i += 16){
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&values[i]));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&values[i]), _mm256_add_epi16(acc, w));
+    }
+#elif defined(ASTRADO_SSE2)
+    for(int i = 0; i < NNUE_HIDDEN; i += 8){
+        __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[i]));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&values[i]), _mm_add_epi16(acc, w));
+    }
+#else
+    for(int i = 0; i < NNUE_HIDDEN; ++i) values[i] += weights[i];
+#endif
+}
+
+void AstraDoNetwork::removeFeature(std::array<int16_t, NNUE_HIDDEN>& values, int feature) const {
+    const int16_t* weights = &ftWeights[feature * NNUE_HIDDEN];
+#if defined(__AVX2__)
+    for(int i = 0; i < NNUE_HIDDEN; i += 16){
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&values[i]));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&values[i]), _mm256_sub_epi16(acc, w));
+    }
+#elif defined(ASTRADO_SSE2)
+    for(int i = 0; i < NNUE_HIDDEN; i += 8){
+        __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[i]));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&values[i]), _mm_sub_epi16(acc, w));
+    }
+#else
+    for(int i = 0; i < NNUE_HIDDEN; ++i) values[i] -= weights[i];
+#endif
+}
+
+void AstraDoNetwork::refresh(NnueAccumulator& accumulator, const AstraDoBoard& board) const {
+    accumulator.values[0] = ftBias;
+    accumulator.values[1] = ftBias;
+    for(uint8_t i = 0; i < 54; ++i){
+        if(board.getBlackPieces()[i]){
+            addFeature(accumulator.values[0], featureIndex(i, true));
+            addFeature(accumulator.values[1], featureIndex(i, false));
+        }
+        else if(board.getWhitePieces()[i]){
+            addFeature(accumulator.values[0], featureIndex(i, false));
+            addFeature(accumulator.values[1], featureIndex(i, true));
+        }
+    }
+    accumulator.generation = generation;
+}
+
+void AstraDoNetwork::addPiece(NnueAccumulator& accumulator, uint8_t square, bool black) const {
+    addFeature(accumulator.values[0], featureIndex(square, black));
+    addFeature(accumulator.values[1], featureIndex(square, !black));
+}
+
+void AstraDoNetwork::flipPiece(NnueAccumulator& accumulator, uint8_t square, bool to_black) const {
+    removeFeature(accumulator.values[0], featureIndex(square, !to_black));
+    addFeature(accumulator.values[0], featureIndex(square, to_black));
+    removeFeature(accumulator.values[1], featureIndex(square, to_black));
+    addFeature(accumulator.values[1], featureIndex(square, !to_black));
+}
+
+int AstraDoNetwork::evaluate(const AstraDoBoard& board) const {
+    // Boards made before the network was loaded have no accumulator yet
+    NnueAccumulator fresh;
+    const NnueAccumulator* accumulator = board.getAccumulator().get();
+    if(!accumulator || accumulator->generation != generation){
+        refresh(fresh, board);
+        accumulator = &fresh;
+    }
+
+    // Clipped ReLU of both perspectives, side to move first
+    alignas(32) std::array<uint8_t, 2 * NNUE_HIDDEN> input;
+    const std::array<int16_t, NNUE_HIDDEN>& own = accumulator->values[board.getTurn() ? 0 : 1];
+    const std::array<int16_t, NNUE_HIDDEN>& oppo = accumulator->values[board.getTurn() ? 1 : 0];
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    for(int half = 0; half < 2; ++half){
+        const int16_t* values = half == 0 ? own.data() : oppo.data();
+        for(int i = 0; i < NNUE_HIDDEN; i += 32){
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + 16));
+            // Saturating pack to int8 clips at 127, max with zero clips below
+            __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(a, b), zero);
+            // Packing works within 128-bit lanes, put the quarters back in order
+            packed = _mm256_permute4x64_epi64(packed, 0xD8);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(&input[half * NNUE_HIDDEN + i]), packed);
+        }
+    }
+#elif defined(ASTRADO_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for(int half = 0; half < 2; ++half){
+        const int16_t* values = half == 0 ? own.data() : oppo.data();
+        for(int i = 0; i < NNUE_HIDDEN; i += 16){
+            // No signed byte max before SSE4.1, so the zero clip is done on the int16 values
+            __m128i a = _mm_max_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), zero);
+            __m128i b = _mm_max_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + 8)), zero);
+            _mm_store_si128(reinterpret_cast<__m128i*>(&input[half * NNUE_HIDDEN + i]), _mm_packs_epi16(a, b));
+        }
+    }
+#else
+    for(int i = 0; i < NNUE_HIDDEN; ++i){
+        input[i] = static_cast<uint8_t>(std::min<int>(FT_SCALE, std::max<int>(0, own[i])));
+        input[NNUE_HIDDEN + i] = static_cast<uint8_t>(std::min<int>(FT_SCALE, std::max<int>(0, oppo[i])));
+    }
+#endif
+
+    // Second layer, uint8 activations times int8 weights
+    std::array<int32_t, NNUE_HIDDEN2> hidden;
+    for(int j = 0; j < NNUE_HIDDEN2; ++j){
+        int32_t sum = 0;
+#if defined(__AVX2__)
+        const __m256i ones = _mm256_set1_epi16(1);
+        __m256i acc = _mm256_setzero_si256();
+        for(int i = 0; i < 2 * NNUE_HIDDEN; i += 32){
+            __m256i in = _mm256_load_si256(reinterpret_cast<const __m256i*>(&input[i]));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&l2Weights[j][i]));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(in, w), ones));
+        }
+        __m128i lanes = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, 0x4E));
+        lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, 0xB1));
+        sum = _mm_cvtsi128_si32(lanes);
+#elif defined(ASTRADO_SSE2)
+        // No unsigned times signed byte multiply before SSSE3, both are widened to int16
+        __m128i acc = _mm_setzero_si128();
+        for(int i = 0; i < 2 * NNUE_HIDDEN; i += 16){
+            __m128i in = _mm_load_si128(reinterpret_cast<const __m128i*>(&input[i]));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&l2Weights[j][i]));
+            __m128i w_low = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+            __m128i w_high = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(in, zero), w_low));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi8(in, zero), w_high));
+        }
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+        sum = _mm_cvtsi128_si32(acc);
+#else
+        for(int i = 0; i < 2 * NNUE_HIDDEN; ++i) sum += input[i] * l2Weights[j][i];
+#endif
+        hidden[j] = std::min(FT_SCALE, std::max(0, (sum + l2Bias[j]) >> WEIGHT_SCALE_BITS));
+    }
+
+    int32_t output = outBias;
+    for(int j = 0; j < NNUE_HIDDEN2; ++j) output += hidden[j] * outWeights[j];
+    // Output is log-odds of the side to move winning, times FT_SCALE * OUTPUT_WEIGHT_SCALE
+    return static_cast<int>(static_cast<int64_t>(output) * EVAL_SCALE / (FT_SCALE * OUTPUT_WEIGHT_SCALE));
+}
+
+double AstraDoNetwork::winProbability(const AstraDoBoard& board) const {
+    // No legal moves can be made + previous move is stale
+    if(board.getMoves().empty() && board.getStale()){
+        std::pair<int, int> piece_count = board.getPieceCount();
+        if(piece_count.first > piece_count.second) return 1.0;
+        if(piece_count.first < piece_count.second) return 0.0;
+        return 0.5;
+    }
+    int score = evaluate(board);
+    if(!board.getTurn()) score = -score;
+    return 1.0 / (1.0 + std::exp(-score / static_cast<double>(EVAL_SCALE)));
+}
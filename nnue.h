@@ -0,0 +1,120 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+template<class Geometry> class BasicBoard;
+struct AstraDoGeometry;
+using AstraDoBoard = BasicBoard<AstraDoGeometry>;
+
+// Hidden units of the first layer, for each perspective
+const int NNUE_HIDDEN = 32;
+// Hidden units of the second layer
+const int NNUE_HIDDEN2 = 16;
+
+// Output of the first layer, kept up to date by AstraDoBoard::makeMove
+// values[0] sees the board as black, values[1] as white
+struct NnueAccumulator {
+    std::array<std::array<int16_t, NNUE_HIDDEN>, 2> values;
+    // Network the values were computed with, 0 if none
+    uint32_t generation = 0;
+};
+
+// Accumulator of a board, allocated on the first refresh
+// Boards stay small while no network is loaded, as with random or truncated rollouts
+class LazyAccumulator {
+private:
+    std::unique_ptr<NnueAccumulator> accumulator;
+
+public:
+    LazyAccumulator() = default;
+    LazyAccumulator(const LazyAccumulator& other)
+        : accumulator(other.accumulator ? new NnueAccumulator(*other.accumulator) : nullptr) {}
+    LazyAccumulator(LazyAccumulator&& other) = default;
+
+    LazyAccumulator& operator=(const LazyAccumulator& other){
+        if(!other.accumulator) accumulator.reset();
+        else if(accumulator) *accumulator = *other.accumulator;
+        else accumulator.reset(new NnueAccumulator(*other.accumulator));
+        return *this;
+    }
+    LazyAccumulator& operator=(LazyAccumulator&& other) = default;
+
+    // nullptr until the first refresh
+    NnueAccumulator* get() const { return accumulator.get(); }
+
+    // The accumulator, allocated if missing
+    NnueAccumulator& create(){
+        if(!accumulator) accumulator.reset(new NnueAccumulator());
+        return *accumulator;
+    }
+};
+
+// Small efficiently updatable neural network evaluating a position
+// Inputs are the 54 squares x 2 colours as seen by one side (own pieces first)
+// Both perspectives share the first layer, the side to move is put first in the second layer
+class AstraDoNetwork {
+private:
+    // First layer, 1.0 is stored as FT_SCALE
+    std::vector<int16_t> ftWeights;     // [108][NNUE_HIDDEN]
+    std::array<int16_t, NNUE_HIDDEN> ftBias{};
+
+    // Second layer, weights are stored with WEIGHT_SCALE
+    std::array<std::array<int8_t, 2 * NNUE_HIDDEN>, NNUE_HIDDEN2> l2Weights{};
+    std::array<int32_t, NNUE_HIDDEN2> l2Bias{};
+
+    // Output layer, weights are stored with OUTPUT_WEIGHT_SCALE
+    std::array<int8_t, NNUE_HIDDEN2> outWeights{};
+    int32_t outBias = 0;
+
+    uint32_t generation = 0;
+
+    static constexpr int FT_SCALE = 127;
+    static constexpr int WEIGHT_SCALE_BITS = 6;
+    static constexpr int OUTPUT_WEIGHT_SCALE = 32;
+
+    // Network used by every board, replaced by load
+    static std::unique_ptr<AstraDoNetwork> current;
+
+    // Add or remove one input of one perspective
+    void addFeature(std::array<int16_t, NNUE_HIDDEN>& values, int feature) const;
+    void removeFeature(std::array<int16_t, NNUE_HIDDEN>& values, int feature) const;
+
+public:
+    // Score of a position relative to the evaluation scale, 1000 is one unit of log-odds
+    static constexpr int EVAL_SCALE = 1000;
+
+    // Load weights and make them the network used by every board
+    // Returns false and keeps the current network if the file cannot be read
+    static bool load(const std::string& path);
+
+    // Load path, or astrado.nnue in the directory of the executable named by argv0 if path is empty
+    static bool loadDefault(const std::string& argv0, const std::string& path);
+
+    // Stop using a network
+    static void unload();
+
+    // Loaded network, nullptr if none
+    static const AstraDoNetwork* active();
+
+    // Compute the accumulator from scratch
+    void refresh(NnueAccumulator& accumulator, const AstraDoBoard& board) const;
+
+    // Incremental updates, colour is true for black
+    void addPiece(NnueAccumulator& accumulator, uint8_t square, bool black) const;
+    void flipPiece(NnueAccumulator& accumulator, uint8_t square, bool to_black) const;
+
+    // Evaluate from the side to move, on the same scale as AstraDoEvaluator
+    int evaluate(const AstraDoBoard& board) const;
+
+    // Probability that black wins
+    double winProbability(const AstraDoBoard& board) const;
+
+    uint32_t getGeneration() const;
+};
+
+#endif // NNUE_H
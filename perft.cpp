@@ -0,0 +1,77 @@
+#include "perft.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+double PerftResult::nodesPerSecond() const {
+    return seconds > 0 ? nodes / seconds : 0;
+}
+
+template<class Geometry>
+long long BasicPerft<Geometry>::count(const Board& board, int depth){
+    if(depth <= 0) return 1;
+    const std::vector<uint8_t>& moves = board.getMoves();
+    if(moves.empty()){
+        // No legal moves can be made + previous move is stale
+        if(board.getStale()) return 0;
+        if(depth == 1) return 1;
+        Board next(board);
+        next.makeMove(Geometry::PASS);
+        return count(next, depth - 1);
+    }
+    // Positions on the last ply are counted without making the moves
+    if(depth == 1) return static_cast<long long>(moves.size());
+    long long nodes = 0;
+    // One scan gives the flips of every move, and assigning to the same board reuses its storage
+    std::vector<typename Board::Bits> flips = board.findFlips();
+    Board next(board);
+    for(size_t i = 0; i < moves.size(); ++i){
+        if(i > 0) next = board;
+        next.makeMove(moves[i], flips[i]);
+        nodes += count(next, depth - 1);
+    }
+    return nodes;
+}
+
+template<class Geometry>
+PerftResult BasicPerft<Geometry>::run(const Board& board, int depth, int threads){
+    PerftResult result;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> moves(board.getMoves());
+    if(moves.empty() && !board.getStale()) moves.push_back(Geometry::PASS);
+    if(depth <= 0 || moves.empty()){
+        result.nodes = count(board, depth);
+    }
+    else{
+        if(threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, static_cast<int>(moves.size()));
+        result.divide.resize(moves.size());
+
+        // Every thread takes the next root move that is not searched yet
+        std::atomic<size_t> next_move{0};
+        auto worker = [&]() {
+            size_t i;
+            while((i = next_move.fetch_add(1)) < moves.size()){
+                Board next(board);
+                next.makeMove(moves[i]);
+                result.divide[i] = {moves[i], count(next, depth - 1)};
+            }
+        };
+        std::vector<std::thread> pool;
+        for(int t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for(std::thread& thread : pool) thread.join();
+
+        for(const std::pair<uint8_t, long long>& entry : result.divide) result.nodes += entry.second;
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+template class BasicPerft<AstraDoGeometry>;
+template class BasicPerft<HexGeometry<3>>;
+template class BasicPerft<HexGeometry<4>>;
+template class BasicPerft<HexGeometry<5>>;
+template class BasicPerft<HexGeometry<6>>;
@@ -0,0 +1,42 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "board.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Result of a timed perft run
+struct PerftResult {
+    long long nodes = 0;
+    double seconds = 0;
+    // Leaf count below every root move, PASS for a pass
+    std::vector<std::pair<uint8_t, long long>> divide;
+
+    double nodesPerSecond() const;
+};
+
+// Move generator test: count the positions reached after exactly depth plies
+// A pass (makeMove(PASS)) counts as a ply when the side to move has no moves,
+// a finished game ends the line early and contributes no positions
+template<class Geometry>
+class BasicPerft {
+public:
+    using Board = BasicBoard<Geometry>;
+
+    static long long count(const Board& board, int depth);
+
+    // Split the root moves among threads (0 for all hardware threads) and time the run
+    static PerftResult run(const Board& board, int depth, int threads = 0);
+};
+
+using AstraDoPerft = BasicPerft<AstraDoGeometry>;
+
+// Geometries compiled into perft.cpp
+extern template class BasicPerft<AstraDoGeometry>;
+extern template class BasicPerft<HexGeometry<3>>;
+extern template class BasicPerft<HexGeometry<4>>;
+extern template class BasicPerft<HexGeometry<5>>;
+extern template class BasicPerft<HexGeometry<6>>;
+
+#endif // PERFT_H
@@ -0,0 +1,161 @@
+#include "pns.h"
+
+namespace {
+
+// Separates the tables of both attackers
+const uint64_t ATTACKER_KEY = 0x9E3779B97F4A7C15ULL;
+
+// Whether the game has ended with a win of the attacker
+bool attackerWins(const AstraDoBoard& board, bool attacker){
+    std::pair<int, int> piece_count = board.getPieceCount();
+    return attacker ? piece_count.first > piece_count.second : piece_count.second > piece_count.first;
+}
+
+}
+
+ProofNumberSearch::ProofNumberSearch(size_t tt_size) : table(tt_size) {
+
+}
+
+uint64_t ProofNumberSearch::tableKey(const AstraDoBoard& board) const {
+    return board.getHash() ^ (attacker ? ATTACKER_KEY : 0);
+}
+
+void ProofNumberSearch::lookup(const Child& child, uint32_t& pn, uint32_t& dn) const {
+    // No legal moves can be made + previous move is stale
+    if(child.board.getMoves().empty() && child.board.getStale()){
+        bool win = attackerWins(child.board, attacker);
+        pn = win ? 0 : INF;
+        dn = win ? INF : 0;
+        return;
+    }
+    size_t bucket = child.key & (table.size() - 1) & ~static_cast<size_t>(1);
+    for(size_t i = bucket; i < bucket + 2; ++i){
+        if(table[i].key == child.key){
+            pn = table[i].pn;
+            dn = table[i].dn;
+            return;
+        }
+    }
+    // Unexplored node
+    pn = 1;
+    dn = 1;
+}
+
+void ProofNumberSearch::store(uint64_t key, uint32_t pn, uint32_t dn, uint32_t work, uint8_t best_move){
+    size_t bucket = key & (table.size() - 1) & ~static_cast<size_t>(1);
+    TTEntry* entry = &table[bucket];
+    if(table[bucket + 1].key == key) entry = &table[bucket + 1];
+    // Replace the entry that took less work
+    else if(table[bucket].key != key && table[bucket + 1].work < table[bucket].work) entry = &table[bucket + 1];
+    entry->key = key;
+    entry->pn = pn;
+    entry->dn = dn;
+    entry->work = work;
+    entry->bestMove = best_move;
+}
+
+void ProofNumberSearch::mid(const AstraDoBoard& board, uint64_t key, uint32_t thpn, uint32_t thdn, uint32_t& pn, uint32_t& dn){
+    long long start_nodes = nodes;
+    ++nodes;
+
+    // Generate all children, a pass if no legal moves can be made
+    std::vector<Child> children;
+    if(board.getMoves().empty()){
+        children.push_back({board, 0, AstraDoGeometry::PASS});
+    }
+    else{
+        children.reserve(board.getMoves().size());
+        for(uint8_t move : board.getMoves()){
+            children.push_back({board, 0, move});
+        }
+    }
+    for(Child& child : children){
+        child.board.makeMove(child.move);
+        child.key = tableKey(child.board);
+    }
+
+    // Attacker to move needs one winning child, defender needs all children to be wins
+    bool or_node = board.getTurn() == attacker;
+    uint8_t best_move = children[0].move;
+    while(true){
+        size_t best = 0;
+        uint32_t best_value = INF;
+        uint32_t second_value = INF;
+        uint32_t sum = 0;
+        uint32_t child_pn = 0, child_dn = 0;
+        for(size_t i = 0; i < children.size(); ++i){
+            lookup(children[i], child_pn, child_dn);
+            uint32_t select_value = or_node ? child_pn : child_dn;
+            sum = std::min(INF, sum + (or_node ? child_dn : child_pn));
+            if(i == 0 || select_value < best_value){
+                if(i > 0) second_value = best_value;
+                best_value = select_value;
+                best = i;
+            }
+            else if(select_value < second_value){
+                second_value = select_value;
+            }
+        }
+        pn = or_node ? best_value : sum;
+        dn = or_node ? sum : best_value;
+        best_move = children[best].move;
+
+        if(pn >= thpn || dn >= thdn || aborted) break;
+        if(nodeBudget > 0 && nodes >= nodeBudget){
+            aborted = true;
+            break;
+        }
+
+        // Descend into the most proving child with tightened thresholds
+        lookup(children[best], child_pn, child_dn);
+        uint32_t child_thpn, child_thdn;
+        if(or_node){
+            child_thpn = std::min(thpn, second_value + 1);
+            child_thdn = thdn - dn + child_dn;
+        }
+        else{
+            child_thpn = thpn - pn + child_pn;
+            child_thdn = std::min(thdn, second_value + 1);
+        }
+        mid(children[best].board, children[best].key, child_thpn, child_thdn, child_pn, child_dn);
+    }
+
+    long long work = nodes - start_nodes;
+    store(key, pn, dn, static_cast<uint32_t>(std::min<long long>(work, UINT32_MAX)), best_move);
+    rootBestMove = best_move;
+}
+
+ProofResult ProofNumberSearch::solve(const AstraDoBoard& board, long long node_budget){
+    return solve(board, board.getTurn(), node_budget);
+}
+
+ProofResult ProofNumberSearch::solve(const AstraDoBoard& board, bool attacker_turn, long long node_budget){
+    attacker = attacker_turn;
+    nodes = 0;
+    nodeBudget = node_budget;
+    aborted = false;
+    rootBestMove = AstraDoGeometry::NO_MOVE;
+
+    // Game has already ended
+    if(board.getMoves().empty() && board.getStale()){
+        return attackerWins(board, attacker) ? ProofResult::Proven : ProofResult::Disproven;
+    }
+
+    uint32_t pn, dn;
+    mid(board, tableKey(board), INF, INF, pn, dn);
+    // Only a proof with the attacker to move comes with a winning move
+    if(board.getTurn() != attacker) rootBestMove = AstraDoGeometry::NO_MOVE;
+
+    if(pn == 0) return ProofResult::Proven;
+    if(dn == 0) return ProofResult::Disproven;
+    return ProofResult::Unknown;
+}
+
+uint8_t ProofNumberSearch::getBestMove() const { return rootBestMove; }
+
+long long ProofNumberSearch::getNodeCount() const { return nodes; }
+
+void ProofNumberSearch::clear(){
+    std::fill(table.begin(), table.end(), TTEntry());
+}
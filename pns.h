@@ -0,0 +1,75 @@
+#ifndef PNS_H
+#define PNS_H
+
+#include "board.h"
+#include <cstdint>
+#include <vector>
+
+// Outcome of a proof-number search
+enum class ProofResult { Proven, Disproven, Unknown };
+
+// Depth-first proof-number search (df-pn)
+// Proves or disproves that a given side wins (ends with more pieces) from a position
+class ProofNumberSearch {
+private:
+    // Transposition table entry, proof and disproof numbers are for the attacker winning
+    struct TTEntry {
+        uint64_t key = 0;
+        uint32_t pn = 1;
+        uint32_t dn = 1;
+        // Nodes spent on the entry, less work is replaced first
+        uint32_t work = 0;
+        uint8_t bestMove = AstraDoGeometry::NO_MOVE;
+    };
+
+    struct Child {
+        AstraDoBoard board;
+        uint64_t key;
+        uint8_t move;
+    };
+
+    // Two entries per bucket, the table never grows
+    std::vector<TTEntry> table;
+
+    bool attacker;
+    long long nodes = 0;
+    long long nodeBudget = 0;
+    bool aborted = false;
+    uint8_t rootBestMove = AstraDoGeometry::NO_MOVE;
+
+    // Default number of transposition table entries (power of 2)
+    static const size_t DEFAULT_TT_SIZE = 1 << 18;
+
+    // Search the node until its proof or disproof number reaches the threshold
+    void mid(const AstraDoBoard& board, uint64_t key, uint32_t thpn, uint32_t thdn, uint32_t& pn, uint32_t& dn);
+
+    // Proof and disproof numbers of a child, from the game result or the table
+    void lookup(const Child& child, uint32_t& pn, uint32_t& dn) const;
+
+    void store(uint64_t key, uint32_t pn, uint32_t dn, uint32_t work, uint8_t best_move);
+
+    uint64_t tableKey(const AstraDoBoard& board) const;
+
+public:
+    static const uint32_t INF = 1u << 30;
+
+    explicit ProofNumberSearch(size_t tt_size = DEFAULT_TT_SIZE);
+
+    // Prove or disprove that the side to move wins within the node budget
+    ProofResult solve(const AstraDoBoard& board, long long node_budget);
+
+    // Prove or disprove that the given side wins (true for black)
+    // Results of earlier calls are kept in the table and reused
+    ProofResult solve(const AstraDoBoard& board, bool attacker_turn, long long node_budget);
+
+    // Move that proves the win, if the root was proven with the attacker to move
+    uint8_t getBestMove() const;
+
+    // Nodes expanded by the last call to solve
+    long long getNodeCount() const;
+
+    // Forget all stored results
+    void clear();
+};
+
+#endif // PNS_H
@@ -0,0 +1,30 @@
+#include "positionfile.h"
+
+PackedPosition PackedPosition::pack(const AstraDoBoard& board){
+    // All 54 squares fit in the first word of the bit sets
+    PackedPosition position;
+    position.black = board.getBlackPieces().word(0);
+    position.white = board.getWhitePieces().word(0);
+    if(board.getTurn()) position.white |= TURN_BIT;
+    if(board.getStale()) position.white |= STALE_BIT;
+    return position;
+}
+
+AstraDoBoard PackedPosition::unpack() const {
+    AstraDoBoard::Bits black_bits, white_bits;
+    black_bits.setWord(0, black & SQUARE_MASK);
+    white_bits.setWord(0, white & SQUARE_MASK);
+    AstraDoBoard board(black_bits, white_bits, (white & TURN_BIT) != 0);
+    board.setStale((white & STALE_BIT) != 0);
+    return board;
+}
+
+bool PackedPosition::isValid() const {
+    if(black & ~SQUARE_MASK) return false;
+    if(white & ~(SQUARE_MASK | TURN_BIT | STALE_BIT)) return false;
+    return (black & white & SQUARE_MASK) == 0;
+}
+
+bool PositionWriter::write(const AstraDoBoard& board){
+    return write(PackedPosition::pack(board));
+}
@@ -0,0 +1,44 @@
+#ifndef POSITIONFILE_H
+#define POSITIONFILE_H
+
+#include "board.h"
+#include "recordfile.h"
+#include <cstdint>
+#include <string>
+
+// Fixed-size binary form of a position, 16 bytes
+// Bit i of a mask is set if square i holds a piece of that colour
+struct PackedPosition {
+    uint64_t black = 0;
+    // Bits 0-53 are the white pieces, TURN_BIT is set if black is to move, STALE_BIT if the previous move was a pass
+    uint64_t white = 0;
+
+    static const uint64_t SQUARE_MASK = (uint64_t(1) << 54) - 1;
+    static const uint64_t TURN_BIT = uint64_t(1) << 62;
+    static const uint64_t STALE_BIT = uint64_t(1) << 63;
+
+    static PackedPosition pack(const AstraDoBoard& board);
+
+    AstraDoBoard unpack() const;
+
+    // No square is taken twice and no unused bit is set
+    bool isValid() const;
+};
+
+static_assert(sizeof(PackedPosition) == 16, "packed position must have no padding");
+
+// Position files are record files of magic "ADPS" with one PackedPosition per position
+inline constexpr RecordFormat POSITION_FILE_FORMAT = {{'A', 'D', 'P', 'S'}, 1};
+
+// Appends positions to a new file, the count in the header is written by close
+class PositionWriter : public RecordWriter<PackedPosition, POSITION_FILE_FORMAT> {
+public:
+    using RecordWriter::write;
+
+    bool write(const AstraDoBoard& board);
+};
+
+// Memory-mapped position file, positions are read in place without loading the file
+using PositionReader = RecordReader<PackedPosition, POSITION_FILE_FORMAT>;
+
+#endif // POSITIONFILE_H
@@ -0,0 +1,76 @@
+#include "recordfile.h"
+#include <cstring>
+
+RecordFileWriter::~RecordFileWriter(){
+    close();
+}
+
+bool RecordFileWriter::writeHeader(){
+    RecordFileHeader header{};
+    std::memcpy(header.magic, format.magic, sizeof(header.magic));
+    header.version = format.version;
+    header.count = count;
+    return std::fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool RecordFileWriter::open(const std::string& path, const RecordFormat& file_format){
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if(!file) return false;
+    format = file_format;
+    count = 0;
+    // Count is filled in by close
+    return writeHeader();
+}
+
+bool RecordFileWriter::write(const void* record, size_t record_size){
+    if(!file || std::fwrite(record, record_size, 1, file) != 1) return false;
+    ++count;
+    return true;
+}
+
+bool RecordFileWriter::close(){
+    if(!file) return false;
+    bool ok = !std::ferror(file);
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && writeHeader();
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+bool RecordFileWriter::isOpen() const { return file != nullptr; }
+
+uint64_t RecordFileWriter::size() const { return count; }
+
+bool RecordFileReader::open(const std::string& path, const RecordFormat& file_format, size_t record_size){
+    close();
+    if(!mapping.open(path)) return false;
+    RecordFileHeader header;
+    if(mapping.size() < sizeof(header)){
+        mapping.close();
+        return false;
+    }
+    std::memcpy(&header, mapping.data(), sizeof(header));
+    if(std::memcmp(header.magic, file_format.magic, sizeof(header.magic)) != 0 || header.version != file_format.version){
+        mapping.close();
+        return false;
+    }
+    // Truncated file
+    if(header.count > (mapping.size() - sizeof(header)) / record_size){
+        mapping.close();
+        return false;
+    }
+    records = mapping.data() + sizeof(header);
+    count = header.count;
+    return true;
+}
+
+void RecordFileReader::close(){
+    mapping.close();
+    records = nullptr;
+    count = 0;
+}
+
+uint64_t RecordFileReader::size() const { return count; }
+
+const uint8_t* RecordFileReader::data() const { return records; }
@@ -0,0 +1,109 @@
+#ifndef RECORDFILE_H
+#define RECORDFILE_H
+
+#include "mappedfile.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Layout of a record file, in native byte order:
+// magic, version, number of records, then the fixed-size records back to back
+struct RecordFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+};
+
+static_assert(sizeof(RecordFileHeader) == 16, "record file header must have no padding");
+
+// Magic and version of one kind of record file
+struct RecordFormat {
+    char magic[4];
+    uint32_t version;
+};
+
+// Appends records of any size to a new file, the count in the header is written by close
+class RecordFileWriter {
+private:
+    std::FILE* file = nullptr;
+    RecordFormat format{};
+    uint64_t count = 0;
+
+    bool writeHeader();
+
+public:
+    RecordFileWriter() = default;
+    ~RecordFileWriter();
+
+    RecordFileWriter(const RecordFileWriter&) = delete;
+    RecordFileWriter& operator=(const RecordFileWriter&) = delete;
+
+    // Create or truncate the file, returns false if it cannot be opened
+    bool open(const std::string& path, const RecordFormat& file_format);
+
+    bool write(const void* record, size_t record_size);
+
+    // Write the final count, returns false if any write failed
+    bool close();
+
+    bool isOpen() const;
+
+    uint64_t size() const;
+};
+
+// Memory-mapped record file, records are read in place without loading the file
+class RecordFileReader {
+private:
+    MappedFile mapping;
+    const uint8_t* records = nullptr;
+    uint64_t count = 0;
+
+public:
+    // Map the file, returns false if it is missing, has another format or is truncated
+    bool open(const std::string& path, const RecordFormat& file_format, size_t record_size);
+
+    void close();
+
+    uint64_t size() const;
+
+    // First record, nullptr if no file is open
+    const uint8_t* data() const;
+};
+
+// Typed forms of the record file classes, for one record type and format
+template<class Record, const RecordFormat& FORMAT>
+class RecordWriter {
+private:
+    RecordFileWriter writer;
+
+public:
+    bool open(const std::string& path){ return writer.open(path, FORMAT); }
+
+    bool write(const Record& record){ return writer.write(&record, sizeof(Record)); }
+
+    bool close(){ return writer.close(); }
+
+    bool isOpen() const { return writer.isOpen(); }
+
+    uint64_t size() const { return writer.size(); }
+};
+
+template<class Record, const RecordFormat& FORMAT>
+class RecordReader {
+private:
+    RecordFileReader reader;
+
+public:
+    bool open(const std::string& path){ return reader.open(path, FORMAT, sizeof(Record)); }
+
+    void close(){ reader.close(); }
+
+    uint64_t size() const { return reader.size(); }
+
+    const Record& operator[](uint64_t index) const {
+        return reinterpret_cast<const Record*>(reader.data())[index];
+    }
+};
+
+#endif // RECORDFILE_H
@@ -0,0 +1,168 @@
+#include "referenceboard.h"
+#include <set>
+
+template<class Geometry>
+BasicReferenceBoard<Geometry>::BasicReferenceBoard(){
+    const GeometryTables& tables = Geometry::tables();
+    for(uint8_t pos : tables.blackStart) black_pieces[pos] = true;
+    for(uint8_t pos : tables.whiteStart) white_pieces[pos] = true;
+    turn = true;
+    stale = false;
+    findLegalMoves();
+}
+
+template<class Geometry>
+BasicReferenceBoard<Geometry>::BasicReferenceBoard(const BasicBoard<Geometry>& board){
+    for(int i = 0; i < CELLS; ++i){
+        black_pieces[i] = board.getBlackPieces()[i];
+        white_pieces[i] = board.getWhitePieces()[i];
+    }
+    turn = board.getTurn();
+    stale = board.getStale();
+    findLegalMoves();
+}
+
+template<class Geometry>
+const std::array<bool, BasicReferenceBoard<Geometry>::CELLS>& BasicReferenceBoard<Geometry>::getBlackPieces() const {
+    return black_pieces;
+}
+
+template<class Geometry>
+const std::array<bool, BasicReferenceBoard<Geometry>::CELLS>& BasicReferenceBoard<Geometry>::getWhitePieces() const {
+    return white_pieces;
+}
+
+template<class Geometry>
+const std::vector<uint8_t>& BasicReferenceBoard<Geometry>::getMoves() const {
+    return moves;
+}
+
+template<class Geometry>
+const std::vector<uint8_t>& BasicReferenceBoard<Geometry>::getFlips() const {
+    return flips;
+}
+
+template<class Geometry>
+bool BasicReferenceBoard<Geometry>::getTurn() const {
+    return turn;
+}
+
+template<class Geometry>
+bool BasicReferenceBoard<Geometry>::getStale() const {
+    return stale;
+}
+
+template<class Geometry>
+std::pair<int, int> BasicReferenceBoard<Geometry>::getPieceCount() const {
+    int black = 0, white = 0;
+    for(int i = 0; i < CELLS; ++i){
+        black += black_pieces[i];
+        white += white_pieces[i];
+    }
+    return std::make_pair(black, white);
+}
+
+template<class Geometry>
+std::string BasicReferenceBoard<Geometry>::toString() const {
+    std::string text(CELLS, '.');
+    for(int i = 0; i < CELLS; ++i){
+        if(black_pieces[i]) text[i] = 'b';
+        else if(white_pieces[i]) text[i] = 'w';
+    }
+    text += turn ? " b " : " w ";
+    text += stale ? '1' : '0';
+    return text;
+}
+
+// A move is an empty square followed on a line by opponent pieces and then an own piece,
+// every line is scanned from both ends
+template<class Geometry>
+void BasicReferenceBoard<Geometry>::findLegalMoves(){
+    const std::array<bool, CELLS>& own_pieces = turn ? black_pieces : white_pieces;
+    const std::array<bool, CELLS>& oppo_pieces = turn ? white_pieces : black_pieces;
+    std::set<uint8_t> moves_set;
+    for(const std::vector<uint8_t>& line : Geometry::tables().lines){
+        for(int direction = 0; direction < 2; ++direction){
+            uint8_t cur_move = NO_MOVE;
+            bool capture_piece = false;
+            for(size_t step = 0; step < line.size(); ++step){
+                uint8_t cur_pos = direction == 0 ? line[step] : line[line.size() - 1 - step];
+                bool own_piece = own_pieces[cur_pos];
+                bool oppo_piece = oppo_pieces[cur_pos];
+                if(cur_move < CELLS){
+                    if(capture_piece){
+                        if(own_piece){
+                            moves_set.insert(cur_move);
+                            cur_move = NO_MOVE;
+                            capture_piece = false;
+                        }
+                        else if(!oppo_piece){
+                            cur_move = NO_MOVE;
+                            capture_piece = false;
+                        }
+                    }
+                    else if(oppo_piece){
+                        capture_piece = true;
+                    }
+                    else if(own_piece){
+                        cur_move = NO_MOVE;
+                    }
+                    else{
+                        cur_move = cur_pos;
+                    }
+                }
+                else if(!own_piece && !oppo_piece){
+                    cur_move = cur_pos;
+                }
+            }
+        }
+    }
+    moves.assign(moves_set.begin(), moves_set.end());
+}
+
+// Walk away from the move along both directions of its three lines,
+// opponent pieces up to the first own piece are flipped
+template<class Geometry>
+void BasicReferenceBoard<Geometry>::makeMove(uint8_t move){
+    flips.clear();
+    if(move >= CELLS){
+        stale = true;
+        turn = !turn;
+        findLegalMoves();
+        return;
+    }
+    const GeometryTables& tables = Geometry::tables();
+    std::array<bool, CELLS>& current_pieces = turn ? black_pieces : white_pieces;
+    std::array<bool, CELLS>& opponent_pieces = turn ? white_pieces : black_pieces;
+    current_pieces[move] = true;
+    std::set<uint8_t> square_set;
+    for(const std::array<uint8_t, 2>& square : tables.squares[move]){
+        const std::vector<uint8_t>& line = tables.lines[square[0]];
+        for(int step : {1, -1}){
+            std::vector<uint8_t> bracketed;
+            for(int pointer = square[1] + step; pointer >= 0 && pointer < static_cast<int>(line.size()); pointer += step){
+                uint8_t cur_pos = line[pointer];
+                if(opponent_pieces[cur_pos]){
+                    bracketed.push_back(cur_pos);
+                    continue;
+                }
+                if(current_pieces[cur_pos]) square_set.insert(bracketed.begin(), bracketed.end());
+                break;
+            }
+        }
+    }
+    for(uint8_t square : square_set){
+        black_pieces[square] = !black_pieces[square];
+        white_pieces[square] = !white_pieces[square];
+    }
+    flips.assign(square_set.begin(), square_set.end());
+    stale = false;
+    turn = !turn;
+    findLegalMoves();
+}
+
+template class BasicReferenceBoard<AstraDoGeometry>;
+template class BasicReferenceBoard<HexGeometry<3>>;
+template class BasicReferenceBoard<HexGeometry<4>>;
+template class BasicReferenceBoard<HexGeometry<5>>;
+template class BasicReferenceBoard<HexGeometry<6>>;
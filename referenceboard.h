@@ -0,0 +1,69 @@
+#ifndef REFERENCEBOARD_H
+#define REFERENCEBOARD_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "board.h"
+
+// Reference model of the rules: the move generator of the board before it moved to bit sets,
+// one bool per cell and ordered sets, kept simple rather than fast
+// Every optimized board has to agree with it on moves, flips, turn and stale flag
+template<class Geometry>
+class BasicReferenceBoard {
+public:
+    static constexpr int CELLS = Geometry::CELLS;
+    static constexpr uint8_t NO_MOVE = Geometry::NO_MOVE;
+
+private:
+    std::array<bool, CELLS> black_pieces{};
+    std::array<bool, CELLS> white_pieces{};
+    std::vector<uint8_t> moves;
+    // Squares flipped by the last move, in increasing order
+    std::vector<uint8_t> flips;
+    bool turn;
+    bool stale;
+
+public:
+    // Initialize board by default
+    BasicReferenceBoard();
+
+    // Copy the position of a board
+    explicit BasicReferenceBoard(const BasicBoard<Geometry>& board);
+
+    const std::array<bool, CELLS>& getBlackPieces() const;
+
+    const std::array<bool, CELLS>& getWhitePieces() const;
+
+    const std::vector<uint8_t>& getMoves() const;
+
+    const std::vector<uint8_t>& getFlips() const;
+
+    bool getTurn() const;
+
+    bool getStale() const;
+
+    std::pair<int, int> getPieceCount() const;
+
+    // Same text form as BasicBoard::toString
+    std::string toString() const;
+
+    // Find all current legal moves in the current state
+    void findLegalMoves();
+
+    // Same contract as BasicBoard::makeMove, move >= CELLS passes
+    void makeMove(uint8_t move);
+};
+
+using ReferenceBoard = BasicReferenceBoard<AstraDoGeometry>;
+
+// Geometries compiled into referenceboard.cpp
+extern template class BasicReferenceBoard<AstraDoGeometry>;
+extern template class BasicReferenceBoard<HexGeometry<3>>;
+extern template class BasicReferenceBoard<HexGeometry<4>>;
+extern template class BasicReferenceBoard<HexGeometry<5>>;
+extern template class BasicReferenceBoard<HexGeometry<6>>;
+
+#endif // REFERENCEBOARD_H
@@ -0,0 +1,32 @@
+#include "search.h"
+#include "mcts.h"
+#include "alphabeta.h"
+
+bool parseSearchAlgorithm(const std::string& name, SearchAlgorithm& algorithm){
+    if(name == "mcts") algorithm = SearchAlgorithm::MCTS;
+    else if(name == "alphabeta") algorithm = SearchAlgorithm::AlphaBeta;
+    else return false;
+    return true;
+}
+
+const char* searchAlgorithmName(SearchAlgorithm algorithm){
+    return algorithm == SearchAlgorithm::AlphaBeta ? "alphabeta" : "mcts";
+}
+
+std::unique_ptr<SearchEngine> createSearchEngine(
+    SearchAlgorithm algorithm,
+    const AstraDoBoard& board,
+    const SearchBudget& budget
+    ){
+    switch(algorithm){
+    case SearchAlgorithm::AlphaBeta:
+        return std::make_unique<AlphaBetaSearch>(board, budget);
+    case SearchAlgorithm::MCTS:
+    default:{
+        std::unique_ptr<MCTS> mcts = std::make_unique<MCTS>(board, budget);
+        // A loaded network is both cheaper and more accurate than a random rollout
+        if(AstraDoNetwork::active()) mcts->setRollout(RolloutType::Evaluation);
+        return mcts;
+    }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "board.h"
+#include <atomic>
+#include <memory>
+#include <string>
+
+// Limits given to a search for a single move
+// A limit of 0 means that the limit is not used
+struct SearchBudget {
+    // Iterations for MCTS, nodes for alpha-beta
+    long long nodes = 0;
+    // Thinking time in milliseconds
+    int timeMs = 0;
+    // Maximum depth, only used by depth-first searchers
+    int depth = 0;
+    // Memory of the search tree in bytes, only used by MCTS
+    size_t memoryBytes = 0;
+};
+
+// Available search algorithms
+enum class SearchAlgorithm { MCTS, AlphaBeta };
+
+// Read an algorithm name, mcts or alphabeta, returns false on an unknown name
+bool parseSearchAlgorithm(const std::string& name, SearchAlgorithm& algorithm);
+
+const char* searchAlgorithmName(SearchAlgorithm algorithm);
+
+// Common interface of all searchers
+// A searcher is created for one position and searches it within its budget
+class SearchEngine {
+public:
+    virtual ~SearchEngine() = default;
+
+    // Interface to get the best move in the current position
+    // Returns 54 if the side to move has no legal moves
+    virtual uint8_t getBestMove() = 0;
+
+    // Number of iterations / nodes visited by the last search
+    virtual long long getNodeCount() const = 0;
+
+    // Stop the search once the flag becomes true, nullptr to remove
+    // The flag may be set from another thread, the best move found so far is returned
+    virtual void setStopFlag(const std::atomic<bool>* flag) = 0;
+};
+
+// Create a searcher of the given algorithm for the position
+std::unique_ptr<SearchEngine> createSearchEngine(
+    SearchAlgorithm algorithm,
+    const AstraDoBoard& board,
+    const SearchBudget& budget
+    );
+
+#endif // SEARCH_H
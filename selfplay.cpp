@@ -0,0 +1,233 @@
+#include "selfplay.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+// Expected score of a player that is the given number of Elo points stronger
+double eloToScore(double elo){
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double scoreToElo(double score){
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+}
+
+bool PlayerConfig::parse(const std::string& text, PlayerConfig& config){
+    std::istringstream items(text);
+    std::string item;
+    while(std::getline(items, item, ',')){
+        if(item.empty()) continue;
+        size_t equals = item.find('=');
+        if(equals == std::string::npos) return false;
+        std::string key = item.substr(0, equals);
+        std::string value = item.substr(equals + 1);
+        if(key == "engine"){
+            if(!parseSearchAlgorithm(value, config.algorithm)) return false;
+        }
+        else if(key == "iterations") config.budget.nodes = std::atoll(value.c_str());
+        else if(key == "time") config.budget.timeMs = std::atoi(value.c_str());
+        else if(key == "c") config.mcts.c = std::atof(value.c_str());
+        else if(key == "minvisits") config.mcts.minVisits = std::atoi(value.c_str());
+        else if(key == "plies") config.mcts.rolloutPlies = std::atoi(value.c_str());
+        else if(key == "rollout" && value == "random") config.mcts.rollout = RolloutType::Random;
+        else if(key == "rollout" && value == "truncated") config.mcts.rollout = RolloutType::Truncated;
+        else if(key == "rollout" && value == "evaluation") config.mcts.rollout = RolloutType::Evaluation;
+        else if(key == "rootpolicy" && value == "ucb") config.mcts.rootPolicy = RootPolicy::UCB;
+        else if(key == "rootpolicy" && value == "halving") config.mcts.rootPolicy = RootPolicy::SequentialHalving;
+        else if(key == "rave") config.mcts.raveK = std::max(0.0, std::atof(value.c_str()));
+        else if(key == "pns" && value == "on") config.mcts.proofNumberSearch = true;
+        else if(key == "pns" && value == "off") config.mcts.proofNumberSearch = false;
+        else return false;
+    }
+    return true;
+}
+
+std::string PlayerConfig::toString() const {
+    static const char* rollout_names[] = {"random", "truncated", "evaluation"};
+    std::ostringstream text;
+    if(algorithm != SearchAlgorithm::MCTS) text << "engine=" << searchAlgorithmName(algorithm) << ",";
+    if(budget.nodes > 0) text << "iterations=" << budget.nodes << ",";
+    if(budget.timeMs > 0) text << "time=" << budget.timeMs << ",";
+    text << "c=" << mcts.c << ",minvisits=" << mcts.minVisits
+         << ",rollout=" << rollout_names[static_cast<int>(mcts.rollout)];
+    if(mcts.rollout == RolloutType::Truncated) text << ",plies=" << mcts.rolloutPlies;
+    if(mcts.rootPolicy == RootPolicy::SequentialHalving) text << ",rootpolicy=halving";
+    if(mcts.raveK > 0) text << ",rave=" << mcts.raveK;
+    if(!mcts.proofNumberSearch) text << ",pns=off";
+    return text.str();
+}
+
+std::unique_ptr<SearchEngine> PlayerConfig::createEngine(const AstraDoBoard& board, uint32_t seed) const {
+    std::unique_ptr<SearchEngine> engine = createSearchEngine(algorithm, board, budget);
+    if(MCTS* tree = dynamic_cast<MCTS*>(engine.get())){
+        mcts.apply(*tree);
+        tree->setSeed(seed);
+    }
+    return engine;
+}
+
+GameRecord SelfPlay::playGame(
+    const AstraDoBoard& start,
+    const PlayerConfig& black,
+    const PlayerConfig& white,
+    uint32_t seed
+    ){
+    GameRecord game;
+    game.start = start;
+    AstraDoBoard board(start);
+    std::seed_seq sequence{seed};
+    std::mt19937 seeds(sequence);
+    // No legal moves can be made + previous move is stale
+    while(!(board.getMoves().empty() && board.getStale())){
+        int side = board.getTurn() ? 0 : 1;
+        uint8_t move = AstraDoGeometry::PASS;
+        if(!board.getMoves().empty()){
+            const PlayerConfig& player = board.getTurn() ? black : white;
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            std::unique_ptr<SearchEngine> engine = player.createEngine(board, seeds());
+            move = engine->getBestMove();
+            game.iterations[side] += engine->getNodeCount();
+            game.seconds[side] += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+        board.makeMove(move);
+        game.moves.push_back(move);
+    }
+    std::pair<int, int> piece_count = board.getPieceCount();
+    game.blackPieces = piece_count.first;
+    game.whitePieces = piece_count.second;
+    return game;
+}
+
+std::vector<TrainingSample> SelfPlay::playTrainingGame(
+    const AstraDoBoard& start,
+    const PlayerConfig& config,
+    int temperature_plies,
+    std::mt19937& rng
+    ){
+    std::vector<TrainingSample> samples;
+    AstraDoBoard board(start);
+    int ply = 0;
+    // No legal moves can be made + previous move is stale
+    while(!(board.getMoves().empty() && board.getStale())){
+        uint8_t move = AstraDoGeometry::PASS;
+        if(!board.getMoves().empty()){
+            TrainingSample sample{};
+            sample.position = PackedPosition::pack(board);
+            sample.ply = static_cast<uint8_t>(std::min(ply, 255));
+            std::unique_ptr<SearchEngine> engine = config.createEngine(board, rng());
+            move = engine->getBestMove();
+            long long total = 0;
+            bool proven_win = false;
+            if(MCTS* mcts = dynamic_cast<MCTS*>(engine.get())){
+                for(MCTSNode* child : mcts->getRoot()->getChildren()){
+                    if(child->getMove() >= AstraDoGeometry::PASS) continue;
+                    sample.visits[child->getMove()] = static_cast<uint16_t>(std::min(child->getNumVisits(), 65535));
+                    total += sample.visits[child->getMove()];
+                }
+                ProvenResult win = board.getTurn() ? ProvenResult::BlackWin : ProvenResult::WhiteWin;
+                proven_win = mcts->getRoot()->getProven() == win;
+            }
+            // Forced move, no search, no root visits or a proven win, the chosen move is the whole distribution
+            if(total == 0 || proven_win){
+                std::fill(std::begin(sample.visits), std::end(sample.visits), 0);
+                sample.visits[move] = 1;
+            }
+            else if(ply < temperature_plies){
+                long long pick = static_cast<long long>(rng() % total);
+                for(uint8_t candidate : board.getMoves()){
+                    pick -= sample.visits[candidate];
+                    if(pick < 0){
+                        move = candidate;
+                        break;
+                    }
+                }
+            }
+            samples.push_back(sample);
+        }
+        board.makeMove(move);
+        ++ply;
+    }
+    std::pair<int, int> piece_count = board.getPieceCount();
+    int diff = piece_count.first - piece_count.second;
+    for(TrainingSample& sample : samples){
+        bool black = (sample.position.white & PackedPosition::TURN_BIT) != 0;
+        sample.result = static_cast<int8_t>(black ? diff : -diff);
+    }
+    return samples;
+}
+
+AstraDoBoard SelfPlay::randomOpening(int plies, std::mt19937& rng){
+    // Openings that already end the game are drawn again
+    while(true){
+        AstraDoBoard board;
+        for(int i = 0; i < plies; ++i){
+            if(board.getMoves().empty()){
+                if(board.getStale()) break;
+                board.makeMove(AstraDoGeometry::PASS);
+            }
+            else{
+                board.makeMove(board.getMoves()[rng() % board.getMoves().size()]);
+            }
+        }
+        if(!(board.getMoves().empty() && board.getStale())) return board;
+    }
+}
+
+std::string SelfPlay::formatGame(const GameRecord& game){
+    std::ostringstream text;
+    text << game.start.toString() << " moves";
+    for(uint8_t move : game.moves){
+        if(move >= AstraDoGeometry::PASS) text << " pass";
+        else text << " " << static_cast<int>(move);
+    }
+    text << " result " << game.blackPieces << "-" << game.whitePieces;
+    return text.str();
+}
+
+int MatchScore::games() const { return wins + draws + losses; }
+
+double MatchScore::score() const {
+    return games() > 0 ? (wins + 0.5 * draws) / games() : 0.5;
+}
+
+double MatchScore::elo() const {
+    double s = score();
+    if(s <= 0 || s >= 1) return s <= 0 ? -INFINITY : INFINITY;
+    return scoreToElo(s);
+}
+
+double MatchScore::eloError() const {
+    int n = games();
+    if(n < 2) return INFINITY;
+    double s = score();
+    double variance = (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / n;
+    double margin = 1.96 * std::sqrt(variance / n);
+    double low = std::max(1e-6, s - margin), high = std::min(1 - 1e-6, s + margin);
+    return (scoreToElo(high) - scoreToElo(low)) / 2;
+}
+
+double MatchScore::llr(double elo0, double elo1) const {
+    int n = games();
+    if(n == 0) return 0;
+    double s = score();
+    double variance = (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / n;
+    // Every game has the same result so far, the variance says nothing yet
+    if(variance <= 0) return 0;
+    double s0 = eloToScore(elo0), s1 = eloToScore(elo1);
+    return n * (s1 - s0) * (2 * s - s0 - s1) / (2 * variance);
+}
+
+double MatchScore::lowerBound(double alpha, double beta){
+    return std::log(beta / (1 - alpha));
+}
+
+double MatchScore::upperBound(double alpha, double beta){
+    return std::log((1 - beta) / alpha);
+}
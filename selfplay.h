@@ -0,0 +1,96 @@
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include "board.h"
+#include "mcts.h"
+#include "search.h"
+#include "trainingdata.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Settings of one side of an engine match
+struct PlayerConfig {
+    SearchAlgorithm algorithm = SearchAlgorithm::MCTS;
+    // Only used by MCTS
+    MCTSConfig mcts;
+    SearchBudget budget;
+
+    // Read "key=value,key=value", keys: engine, iterations, time, c, minvisits, rollout, plies, rootpolicy, rave, pns
+    // Returns false on an unknown key or value
+    static bool parse(const std::string& text, PlayerConfig& config);
+
+    std::string toString() const;
+
+    // Searcher of the configured algorithm for the position, an MCTS searcher is seeded from the seed
+    std::unique_ptr<SearchEngine> createEngine(const AstraDoBoard& board, uint32_t seed) const;
+};
+
+// A finished game
+struct GameRecord {
+    AstraDoBoard start;
+    // Moves played from the start position, 54 for a pass
+    std::vector<uint8_t> moves;
+    int blackPieces = 0;
+    int whitePieces = 0;
+    // Search effort of black and white
+    long long iterations[2] = {0, 0};
+    double seconds[2] = {0, 0};
+};
+
+// Games between two engine configurations
+class SelfPlay {
+public:
+    // Play a game to the end, searches are seeded from the seed
+    static GameRecord playGame(
+        const AstraDoBoard& start,
+        const PlayerConfig& black,
+        const PlayerConfig& white,
+        uint32_t seed
+        );
+
+    // Play a game of the configuration against itself, with a sample for every position with a legal move
+    // For the first temperature_plies plies the move is drawn in proportion to the root visits, for variety
+    // Searchers without root visits give the chosen move as the whole distribution
+    static std::vector<TrainingSample> playTrainingGame(
+        const AstraDoBoard& start,
+        const PlayerConfig& config,
+        int temperature_plies,
+        std::mt19937& rng
+        );
+
+    // Position after a number of random moves, so that games of a match differ
+    static AstraDoBoard randomOpening(int plies, std::mt19937& rng);
+
+    // One line per game: start position, moves and final piece count
+    static std::string formatGame(const GameRecord& game);
+};
+
+// Win/draw/loss count of a match, from the first player's point of view
+struct MatchScore {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const;
+
+    // Points per game, 1 for a win and 0.5 for a draw
+    double score() const;
+
+    // Elo difference and the half-width of its 95% confidence interval
+    double elo() const;
+
+    double eloError() const;
+
+    // Log-likelihood ratio of elo1 against elo0, with a normal approximation of the score
+    double llr(double elo0, double elo1) const;
+
+    // Bounds of the sequential probability ratio test for the error rates
+    static double lowerBound(double alpha, double beta);
+
+    static double upperBound(double alpha, double beta);
+};
+
+#endif // SELFPLAY_H
@@ -0,0 +1,254 @@
+#include "sessionpool.h"
+#include <algorithm>
+#include <limits>
+
+SessionPool::SessionPool(int threads, size_t memory_bytes, const MCTSConfig& mcts_config, SearchAlgorithm search_algorithm) :
+    config(mcts_config),
+    algorithm(search_algorithm),
+    memoryBudget(memory_bytes){
+    for(int t = 0; t < std::max(1, threads); ++t) workers.emplace_back(&SessionPool::workerLoop, this);
+}
+
+SessionPool::~SessionPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    workAvailable.notify_all();
+    for(std::thread& worker : workers) worker.join();
+}
+
+std::shared_ptr<SessionPool::Session> SessionPool::find(int id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sessions.find(id);
+    return it == sessions.end() ? nullptr : it->second;
+}
+
+void SessionPool::resetTree(Session& session, const AstraDoBoard& board){
+    session.mcts.reset(new MCTS(board));
+    config.apply(*session.mcts);
+    session.mcts->setSeed(static_cast<uint32_t>(session.id));
+    session.mcts->setStopFlag(&session.stopRequested);
+    session.mcts->setMemoryLimit(sessionMemoryLimit);
+    session.memoryBytes = session.mcts->getMemoryUsage();
+}
+
+void SessionPool::updateMemoryLimit(){
+    sessionMemoryLimit = memoryBudget > 0 && !sessions.empty() ? memoryBudget / sessions.size() : memoryBudget;
+}
+
+void SessionPool::trimSessions(){
+    std::vector<std::shared_ptr<Session>> open;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const auto& entry : sessions) open.push_back(entry.second);
+    }
+    for(const std::shared_ptr<Session>& session : open){
+        // A worker holds the mutex of a searching session, that tree is cut when it resumes
+        std::unique_lock<std::mutex> lock(session->mutex, std::try_to_lock);
+        if(!lock.owns_lock() || session->searching || session->closed) continue;
+        session->mcts->setMemoryLimit(sessionMemoryLimit);
+        session->mcts->trimTree();
+        session->memoryBytes = session->mcts->getMemoryUsage();
+    }
+}
+
+int SessionPool::createSession(const AstraDoBoard& board){
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        session->id = nextId++;
+        sessions[session->id] = session;
+        updateMemoryLimit();
+    }
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        resetTree(*session, board);
+    }
+    // Existing sessions get a smaller share
+    trimSessions();
+    return session->id;
+}
+
+SessionResult SessionPool::closeSession(int id){
+    std::shared_ptr<Session> session;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = sessions.find(id);
+        if(it == sessions.end()) return SessionResult::UnknownSession;
+        session = it->second;
+        sessions.erase(it);
+        updateMemoryLimit();
+    }
+    // Closed before the stop is requested, so the slice that ends on the stop sees it
+    {
+        std::lock_guard<std::recursive_mutex> lock(session->callbackMutex);
+        session->closed = true;
+    }
+    // A worker drops the session after its current slice, the tree is freed with the last reference
+    session->stopRequested = true;
+    return SessionResult::Ok;
+}
+
+SessionResult SessionPool::setPosition(int id, const AstraDoBoard& board){
+    std::shared_ptr<Session> session = find(id);
+    if(!session) return SessionResult::UnknownSession;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if(session->closed) return SessionResult::UnknownSession;
+    if(session->searching) return SessionResult::Busy;
+    resetTree(*session, board);
+    return SessionResult::Ok;
+}
+
+SessionResult SessionPool::playMove(int id, uint8_t move){
+    std::shared_ptr<Session> session = find(id);
+    if(!session) return SessionResult::UnknownSession;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if(session->closed) return SessionResult::UnknownSession;
+    if(session->searching) return SessionResult::Busy;
+    const AstraDoBoard& board = session->mcts->getRoot()->getAstraDoBoard();
+    const std::vector<uint8_t>& moves = board.getMoves();
+    if(board.getStale() && moves.empty()) return SessionResult::GameOver;
+    // Passing is only allowed without legal moves
+    bool legal = move >= AstraDoGeometry::PASS ? moves.empty() : std::find(moves.begin(), moves.end(), move) != moves.end();
+    if(!legal) return SessionResult::IllegalMove;
+    session->mcts->advance(move);
+    session->memoryBytes = session->mcts->getMemoryUsage();
+    return SessionResult::Ok;
+}
+
+SessionResult SessionPool::search(int id, const SearchBudget& budget, SessionCallback callback){
+    std::shared_ptr<Session> session = find(id);
+    if(!session) return SessionResult::UnknownSession;
+    std::unique_lock<std::mutex> lock(session->mutex);
+    if(session->closed) return SessionResult::UnknownSession;
+    if(session->searching) return SessionResult::Busy;
+    const AstraDoBoard& board = session->mcts->getRoot()->getAstraDoBoard();
+    if(board.getStale() && board.getMoves().empty()) return SessionResult::GameOver;
+    // Forced moves are played without a search
+    if(board.getMoves().size() <= 1){
+        uint8_t move = board.getMoves().empty() ? AstraDoGeometry::PASS : board.getMoves()[0];
+        lock.unlock();
+        callback(id, move, 0);
+        return SessionResult::Ok;
+    }
+    // Same limits as a single MCTS, 10000 iterations if none is given
+    session->timeLimited = budget.timeMs > 0;
+    session->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget.timeMs);
+    if(budget.nodes > 0) session->iterationsLeft = budget.nodes;
+    else session->iterationsLeft = session->timeLimited ? std::numeric_limits<long long>::max() : 10000;
+    session->iterationsDone = 0;
+    session->budget = budget;
+    session->callback = std::move(callback);
+    session->stopRequested = false;
+    session->searching = true;
+    {
+        std::lock_guard<std::mutex> pool_lock(mutex);
+        queue.push_back(session);
+        ++searchingCount;
+    }
+    workAvailable.notify_one();
+    return SessionResult::Ok;
+}
+
+SessionResult SessionPool::stop(int id){
+    std::shared_ptr<Session> session = find(id);
+    if(!session) return SessionResult::UnknownSession;
+    // No lock, the running slice sees the flag within a few iterations
+    session->stopRequested = true;
+    return SessionResult::Ok;
+}
+
+SessionResult SessionPool::getPosition(int id, AstraDoBoard& board) const {
+    std::shared_ptr<Session> session = find(id);
+    if(!session) return SessionResult::UnknownSession;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if(session->closed) return SessionResult::UnknownSession;
+    board = session->mcts->getRoot()->getAstraDoBoard();
+    return SessionResult::Ok;
+}
+
+SessionPoolStatus SessionPool::getStatus() const {
+    SessionPoolStatus status;
+    std::lock_guard<std::mutex> lock(mutex);
+    status.sessions = static_cast<int>(sessions.size());
+    status.searching = searchingCount;
+    for(const auto& entry : sessions) status.memoryBytes += entry.second->memoryBytes;
+    status.sessionMemoryLimit = sessionMemoryLimit;
+    return status;
+}
+
+bool SessionPool::runSlice(Session& session){
+    if(algorithm != SearchAlgorithm::MCTS){
+        // Stopped before it started, the first legal move is played
+        const AstraDoBoard& board = session.mcts->getRoot()->getAstraDoBoard();
+        session.chosenMove = board.getMoves()[0];
+        if(session.closed || session.stopRequested) return false;
+        std::unique_ptr<SearchEngine> engine = createSearchEngine(algorithm, board, session.budget);
+        engine->setStopFlag(&session.stopRequested);
+        session.chosenMove = engine->getBestMove();
+        session.iterationsDone = engine->getNodeCount();
+        return false;
+    }
+    if(session.closed || session.stopRequested || session.mcts->getRoot()->isProven()) return false;
+    SearchBudget slice;
+    slice.nodes = std::min<long long>(session.iterationsLeft, SLICE_ITERATIONS);
+    slice.timeMs = SLICE_MS;
+    if(session.timeLimited){
+        long long left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            session.deadline - std::chrono::steady_clock::now()).count();
+        if(left <= 0) return false;
+        slice.timeMs = static_cast<int>(std::min<long long>(left, SLICE_MS));
+    }
+    // Share may have shrunk since the last slice
+    session.mcts->setMemoryLimit(sessionMemoryLimit);
+    session.mcts->setBudget(slice);
+    session.mcts->run();
+    session.iterationsDone += session.mcts->getNodeCount();
+    session.iterationsLeft -= session.mcts->getNodeCount();
+    session.memoryBytes = session.mcts->getMemoryUsage();
+    if(session.iterationsLeft <= 0 || session.stopRequested || session.mcts->getRoot()->isProven()) return false;
+    return !session.timeLimited || std::chrono::steady_clock::now() < session.deadline;
+}
+
+uint8_t SessionPool::finishSearch(Session& session){
+    session.searching = false;
+    return algorithm == SearchAlgorithm::MCTS ? session.mcts->chooseMove() : session.chosenMove;
+}
+
+void SessionPool::workerLoop(){
+    while(true){
+        std::shared_ptr<Session> session;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this]() { return shuttingDown || !queue.empty(); });
+            if(shuttingDown) return;
+            session = queue.front();
+            queue.pop_front();
+        }
+        bool more;
+        uint8_t move = AstraDoGeometry::PASS;
+        long long iterations = 0;
+        SessionCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(session->mutex);
+            more = runSlice(*session);
+            if(!more){
+                move = finishSearch(*session);
+                iterations = session->iterationsDone;
+                callback = std::move(session->callback);
+                session->callback = nullptr;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(more) queue.push_back(session);
+            else --searchingCount;
+        }
+        // Called without the session mutex, so that the callback may start the next search
+        if(!more && callback){
+            std::lock_guard<std::recursive_mutex> lock(session->callbackMutex);
+            if(!session->closed) callback(session->id, move, iterations);
+        }
+    }
+}
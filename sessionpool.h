@@ -0,0 +1,141 @@
+#ifndef SESSIONPOOL_H
+#define SESSIONPOOL_H
+
+#include "board.h"
+#include "mcts.h"
+#include "search.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Outcome of a request to a session
+enum class SessionResult { Ok, UnknownSession, Busy, IllegalMove, GameOver };
+
+// Called on a worker thread when a search ends, with the chosen move (54 for a pass) and the iterations spent
+using SessionCallback = std::function<void(int id, uint8_t move, long long iterations)>;
+
+// Load of the pool at one moment
+struct SessionPoolStatus {
+    int sessions = 0;
+    int searching = 0;
+    size_t memoryBytes = 0;
+    // Memory cap of every session, 0 if unlimited
+    size_t sessionMemoryLimit = 0;
+};
+
+// Game sessions with persistent search trees, searched on one shared set of worker threads
+// A search is run in short slices; a session goes to the back of the queue after every slice,
+// so all searching sessions advance at the same rate however many there are
+// The memory budget is split evenly among the open sessions
+// Slices always have a time limit, so sessions search with UCB at the root even if halving is configured
+// Searchers other than MCTS keep no tree between searches, they run a whole search in one slice
+class SessionPool {
+private:
+    struct Session {
+        int id;
+        std::unique_ptr<MCTS> mcts;
+        // Held by a worker for a whole slice
+        std::mutex mutex;
+        bool searching = false;
+        std::atomic<bool> stopRequested{false};
+        std::atomic<bool> closed{false};
+        // Held while the callback runs and while the session is closed, so no callback comes after closeSession
+        // Recursive, as a callback may close its own session
+        std::recursive_mutex callbackMutex;
+        // Remaining work of the running search, iterations are unlimited if only time is
+        long long iterationsLeft = 0;
+        bool timeLimited = false;
+        std::chrono::steady_clock::time_point deadline;
+        long long iterationsDone = 0;
+        // Budget of the running search as given, for searchers other than MCTS
+        SearchBudget budget;
+        // Move found by a searcher other than MCTS
+        uint8_t chosenMove = AstraDoGeometry::NO_MOVE;
+        SessionCallback callback;
+        std::atomic<size_t> memoryBytes{0};
+    };
+
+    // Work of one slice, small enough that a waiting session is picked up again within a few slices
+    static const int SLICE_ITERATIONS = 2048;
+    static const int SLICE_MS = 20;
+
+    MCTSConfig config;
+    // The tree of a session only follows the position if the algorithm is not MCTS
+    SearchAlgorithm algorithm;
+    size_t memoryBudget;
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::map<int, std::shared_ptr<Session>> sessions;
+    // Searching sessions waiting for their next slice, in order
+    std::deque<std::shared_ptr<Session>> queue;
+    int nextId = 1;
+    int searchingCount = 0;
+    bool shuttingDown = false;
+    std::atomic<size_t> sessionMemoryLimit{0};
+    std::vector<std::thread> workers;
+
+    std::shared_ptr<Session> find(int id) const;
+
+    // New tree at the position, the session mutex has to be held
+    void resetTree(Session& session, const AstraDoBoard& board);
+
+    // Share the budget among the sessions, the pool mutex has to be held
+    void updateMemoryLimit();
+
+    // Cut idle trees down to the current share, searching trees are cut by their next slice
+    void trimSessions();
+
+    // Run one slice of the session, returns true if its search is not finished
+    bool runSlice(Session& session);
+
+    // End the search of the session and choose its move, the session mutex has to be held
+    uint8_t finishSearch(Session& session);
+
+    void workerLoop();
+
+public:
+    // memory_bytes is the budget of all trees together, 0 for no limit
+    SessionPool(
+        int threads,
+        size_t memory_bytes,
+        const MCTSConfig& mcts_config = MCTSConfig(),
+        SearchAlgorithm search_algorithm = SearchAlgorithm::MCTS
+        );
+    ~SessionPool();
+
+    SessionPool(const SessionPool&) = delete;
+    SessionPool& operator=(const SessionPool&) = delete;
+
+    // Open a session at the position, returns its id
+    int createSession(const AstraDoBoard& board);
+
+    // A running search is stopped without calling its callback, a callback that already runs is waited for
+    SessionResult closeSession(int id);
+
+    // Replace the position, the tree is discarded
+    SessionResult setPosition(int id, const AstraDoBoard& board);
+
+    // Play a legal move (54 for a pass), the subtree below the move is kept for the next search
+    SessionResult playMove(int id, uint8_t move);
+
+    // Search the position within the budget, the callback is called once the search ends
+    // Sessions with a single legal move get their callback before this returns
+    SessionResult search(int id, const SearchBudget& budget, SessionCallback callback);
+
+    // End the search early, the callback still reports the best move so far
+    SessionResult stop(int id);
+
+    SessionResult getPosition(int id, AstraDoBoard& board) const;
+
+    SessionPoolStatus getStatus() const;
+};
+
+#endif // SESSIONPOOL_H
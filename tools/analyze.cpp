@@ -0,0 +1,258 @@
+#include "mcts.h"
+#include "nnue.h"
+#include "pns.h"
+#include "positionfile.h"
+#include "search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Batch analysis of a position file on all cores
+// Results are written in input order, one line per position
+namespace {
+
+void printUsage(){
+    std::fprintf(stderr,
+        "Usage: analyze <positions> [--iterations N] [--time MS] [--engine mcts|alphabeta] [--solve [NODES]]\n"
+        "               [--threads N] [--out FILE] [--network FILE]\n"
+        "       analyze <positions> --pack FILE\n"
+        "Positions are a binary position file, or text with one position per line as printed by show\n"
+        "--pack converts the positions to a binary position file instead of analysing them\n"
+        "Output lines: index bestmove winrate iterations, or index result bestmove nodes with --solve\n"
+        "The win rate is - if the search gives none, as alpha-beta does\n");
+}
+
+// Positions analysed ahead of the oldest unwritten result, bounds the memory of pending lines
+const uint64_t RESULT_WINDOW = 4096;
+
+// Text positions are read into memory, binary files are mapped
+struct PositionSource {
+    PositionReader reader;
+    std::vector<PackedPosition> positions;
+    bool mapped = false;
+
+    bool open(const std::string& path){
+        if(reader.open(path)){
+            mapped = true;
+            return true;
+        }
+        std::ifstream in(path);
+        if(!in) return false;
+        std::string line;
+        AstraDoBoard board;
+        while(std::getline(in, line)){
+            if(!line.empty() && line.back() == '\r') line.pop_back();
+            if(line.empty() || line[0] == '#') continue;
+            if(!AstraDoBoard::fromString(line, board)){
+                std::fprintf(stderr, "invalid position: %s\n", line.c_str());
+                return false;
+            }
+            positions.push_back(PackedPosition::pack(board));
+        }
+        return true;
+    }
+
+    uint64_t size() const { return mapped ? reader.size() : positions.size(); }
+
+    const PackedPosition& operator[](uint64_t index) const { return mapped ? reader[index] : positions[index]; }
+};
+
+std::string searchPosition(uint64_t index, const AstraDoBoard& board, SearchAlgorithm algorithm, const SearchBudget& budget){
+    std::ostringstream line;
+    line << index << " ";
+    if(board.getMoves().empty() && board.getStale()){
+        line << "none - 0";
+        return line.str();
+    }
+    std::unique_ptr<SearchEngine> engine = createSearchEngine(algorithm, board, budget);
+    MCTS* mcts = dynamic_cast<MCTS*>(engine.get());
+    // Same result for the same file, whatever thread picks the position
+    if(mcts) mcts->setSeed(static_cast<uint32_t>(index));
+    uint8_t move = engine->getBestMove();
+    line << AstraDoBoard::moveToString(move) << " ";
+    AnalysisSnapshot analysis;
+    if(mcts) analysis = mcts->getAnalysis(1);
+    // Forced moves are played without a search
+    if(analysis.lineCount > 0 && engine->getNodeCount() > 0) line << analysis.lines[0].winRate;
+    else line << "-";
+    line << " " << engine->getNodeCount();
+    return line.str();
+}
+
+std::string solvePosition(uint64_t index, const AstraDoBoard& board, ProofNumberSearch& pns, long long budget){
+    std::ostringstream line;
+    line << index << " ";
+    if(board.getMoves().empty() && board.getStale()){
+        std::pair<int, int> piece_count = board.getPieceCount();
+        int diff = board.getTurn() ? piece_count.first - piece_count.second : piece_count.second - piece_count.first;
+        line << (diff > 0 ? "win" : (diff < 0 ? "loss" : "draw")) << " none 0";
+        return line.str();
+    }
+    // Results are from the side to move
+    bool turn = board.getTurn();
+    ProofResult win = pns.solve(board, turn, budget);
+    long long nodes = pns.getNodeCount();
+    if(win == ProofResult::Proven){
+        line << "win " << AstraDoBoard::moveToString(pns.getBestMove()) << " " << nodes;
+        return line.str();
+    }
+    if(win == ProofResult::Unknown){
+        line << "unknown - " << nodes;
+        return line.str();
+    }
+    ProofResult loss = pns.solve(board, !turn, budget);
+    nodes += pns.getNodeCount();
+    if(loss == ProofResult::Proven) line << "loss";
+    else if(loss == ProofResult::Disproven) line << "draw";
+    else line << "unknown";
+    line << " - " << nodes;
+    return line.str();
+}
+
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2 || argv[1][0] == '-'){
+        printUsage();
+        return 2;
+    }
+    std::string input_path = argv[1];
+    SearchBudget budget;
+    SearchAlgorithm algorithm = SearchAlgorithm::MCTS;
+    bool solve = false;
+    long long solve_nodes = 100000;
+    int threads = 0;
+    std::string out_path, pack_path, network_path;
+    for(int i = 2; i < argc; ++i){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--iterations" && has_value) budget.nodes = std::atoll(argv[++i]);
+        else if(arg == "--time" && has_value) budget.timeMs = std::atoi(argv[++i]);
+        else if(arg == "--engine" && has_value){
+            if(!parseSearchAlgorithm(argv[++i], algorithm)){
+                printUsage();
+                return 2;
+            }
+        }
+        else if(arg == "--solve"){
+            solve = true;
+            if(has_value && argv[i + 1][0] != '-') solve_nodes = std::atoll(argv[++i]);
+        }
+        else if(arg == "--threads" && has_value) threads = std::atoi(argv[++i]);
+        else if(arg == "--out" && has_value) out_path = argv[++i];
+        else if(arg == "--pack" && has_value) pack_path = argv[++i];
+        else if(arg == "--network" && has_value) network_path = argv[++i];
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+    if(budget.nodes <= 0 && budget.timeMs <= 0) budget.nodes = 1000;
+
+    PositionSource source;
+    if(!source.open(input_path)){
+        std::fprintf(stderr, "cannot read %s\n", input_path.c_str());
+        return 1;
+    }
+    uint64_t count = source.size();
+
+    if(!pack_path.empty()){
+        PositionWriter writer;
+        bool ok = writer.open(pack_path);
+        for(uint64_t i = 0; ok && i < count; ++i) ok = writer.write(source[i]);
+        if(!writer.close() || !ok){
+            std::fprintf(stderr, "cannot write %s\n", pack_path.c_str());
+            return 1;
+        }
+        std::fprintf(stderr, "packed %llu positions\n", static_cast<unsigned long long>(count));
+        return 0;
+    }
+
+    AstraDoNetwork::loadDefault(argv[0], network_path);
+    if(threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::FILE* out = stdout;
+    if(!out_path.empty() && !(out = std::fopen(out_path.c_str(), "w"))){
+        std::fprintf(stderr, "cannot write %s\n", out_path.c_str());
+        return 1;
+    }
+
+    // Finished lines wait in a ring until every earlier line has been written
+    struct Slot {
+        bool ready = false;
+        std::string line;
+    };
+    std::vector<Slot> window(RESULT_WINDOW);
+    std::mutex mutex;
+    std::condition_variable result_ready;
+    std::condition_variable space_free;
+    std::atomic<uint64_t> next_index{0};
+    uint64_t written = 0;
+
+    auto worker = [&]() {
+        ProofNumberSearch pns;
+        uint64_t index;
+        while((index = next_index.fetch_add(1)) < count){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                space_free.wait(lock, [&]() { return index < written + RESULT_WINDOW; });
+            }
+            const PackedPosition& position = source[index];
+            std::string line;
+            if(!position.isValid()) line = std::to_string(index) + " invalid";
+            else if(solve) line = solvePosition(index, position.unpack(), pns, solve_nodes);
+            else line = searchPosition(index, position.unpack(), algorithm, budget);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                window[index % RESULT_WINDOW] = {true, std::move(line)};
+            }
+            result_ready.notify_one();
+        }
+    };
+    std::vector<std::thread> pool;
+    for(int t = 0; t < threads; ++t) pool.emplace_back(worker);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last_report = start;
+    for(uint64_t i = 0; i < count; ++i){
+        std::string line;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Slot& slot = window[i % RESULT_WINDOW];
+            result_ready.wait(lock, [&]() { return slot.ready; });
+            line = std::move(slot.line);
+            slot.ready = false;
+            ++written;
+        }
+        space_free.notify_all();
+        std::fprintf(out, "%s\n", line.c_str());
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now - last_report >= std::chrono::seconds(1)){
+            double seconds = std::chrono::duration<double>(now - start).count();
+            std::fprintf(stderr, "%llu / %llu positions, %.1f per second\n",
+                         static_cast<unsigned long long>(i + 1), static_cast<unsigned long long>(count), (i + 1) / seconds);
+            last_report = now;
+        }
+    }
+    for(std::thread& thread : pool) thread.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%llu positions in %.2f s, %.1f per second\n",
+                 static_cast<unsigned long long>(count), seconds, seconds > 0 ? count / seconds : 0);
+    if(out != stdout && std::fclose(out) != 0){
+        std::fprintf(stderr, "cannot write %s\n", out_path.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "board.h"
+#include "mcts.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct BenchPosition {
+    const char* name;
+    // Empty for the initial position
+    const char* position;
+};
+
+// Fixed positions so that numbers of different builds can be compared
+const BenchPosition bench_positions[] = {
+    {"initial", ""},
+    {"middle", "wbwwbb.wwbbbw.....b........b.b......w.w......w.bb..... b 0"},
+    {"late", "bwbwbwwwwbwww...bbbbbbbb...b.ww.....bbbw.b...b.ww..bb. b 0"},
+};
+
+struct BenchResult {
+    std::string name;
+    std::string position;
+    long long operations;
+    double seconds;
+    // Extra value printed with the result, such as the size of the tree
+    std::string extraName;
+    long long extra = 0;
+
+    BenchResult(std::string name, std::string position, long long operations, double seconds)
+        : name(std::move(name)), position(std::move(position)), operations(operations), seconds(seconds) {}
+};
+
+// Keeps the compiler from removing the measured work
+volatile long long sink = 0;
+
+// Repeat the operation in growing batches until the time is used up
+template <typename Operation>
+BenchResult measure(const std::string& name, const std::string& position, double min_seconds, Operation operation){
+    long long operations = 0;
+    long long batch = 1;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double seconds = 0;
+    while(seconds < min_seconds){
+        for(long long i = 0; i < batch; ++i) operation();
+        operations += batch;
+        batch *= 2;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return {name, position, operations, seconds};
+}
+
+void printJson(const std::vector<BenchResult>& results){
+    std::printf("{\n  \"benchmarks\": [\n");
+    for(size_t i = 0; i < results.size(); ++i){
+        const BenchResult& result = results[i];
+        std::printf("    {\"name\": \"%s\", \"position\": \"%s\", \"operations\": %lld, \"seconds\": %.6f, "
+                    "\"ns_per_op\": %.1f, \"ops_per_second\": %.1f",
+                    result.name.c_str(), result.position.c_str(), result.operations, result.seconds,
+                    result.seconds * 1e9 / result.operations, result.operations / result.seconds);
+        if(!result.extraName.empty()) std::printf(", \"%s\": %lld", result.extraName.c_str(), result.extra);
+        std::printf("}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+}
+
+int main(int argc, char* argv[]){
+    // Shorter runs for a quick check, numbers are noisier
+    double min_seconds = 1.0;
+    int search_iterations = 20000;
+    int tree_iterations = 200000;
+    for(int i = 1; i < argc; ++i){
+        if(std::strcmp(argv[i], "--quick") == 0){
+            min_seconds = 0.2;
+            search_iterations = 5000;
+            tree_iterations = 50000;
+        }
+        else{
+            std::fprintf(stderr, "Usage: bench [--quick]\nResults are written to stdout as JSON\n");
+            return 2;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for(const BenchPosition& entry : bench_positions){
+        AstraDoBoard board;
+        if(entry.position[0]) AstraDoBoard::fromString(entry.position, board);
+        const std::vector<uint8_t> moves = board.getMoves();
+        std::fprintf(stderr, "position %s\n", entry.name);
+
+        results.push_back(measure("find_legal_moves", entry.name, min_seconds, [&]() {
+            board.findLegalMoves();
+            sink += board.getMoves().size();
+        }));
+
+        results.push_back(measure("board_copy", entry.name, min_seconds, [&]() {
+            AstraDoBoard copy(board);
+            sink += copy.getTurn();
+        }));
+
+        // Every legal move in turn, the copy is included
+        size_t next_move = 0;
+        results.push_back(measure("copy_make_move", entry.name, min_seconds, [&]() {
+            AstraDoBoard copy(board);
+            copy.makeMove(moves[next_move]);
+            next_move = next_move + 1 == moves.size() ? 0 : next_move + 1;
+            sink += copy.getMoves().size();
+        }));
+
+        // All children of a node at once, as when the tree grows
+        results.push_back(measure("node_expand", entry.name, min_seconds, [&]() {
+            MCTSNode parent(board, nullptr, AstraDoGeometry::NO_MOVE);
+            parent.expand();
+            sink += parent.getChildren().size();
+        }));
+
+        MCTSNode node(board, nullptr, AstraDoGeometry::NO_MOVE);
+        std::mt19937 rng(1);
+        results.push_back(measure("random_rollout", entry.name, min_seconds, [&]() {
+            sink += static_cast<long long>(node.random_rollout(rng).score);
+        }));
+
+        // Selection on a large tree, grown quickly with static evaluation instead of rollouts
+        MCTS tree(board, tree_iterations);
+        tree.setRollout(RolloutType::Evaluation);
+        tree.run();
+        BenchResult select = measure("mcts_select", entry.name, min_seconds, [&]() {
+            sink += tree.select(tree.getRoot())->getNumVisits();
+        });
+        select.extraName = "tree_nodes";
+        select.extra = tree.getTreeSize();
+        results.push_back(select);
+
+        // Full search with the default settings, one operation is one iteration
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        long long iterations = 0;
+        while(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < min_seconds){
+            MCTS search(board, search_iterations);
+            sink += search.getBestMove();
+            iterations += search.getNodeCount();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        results.push_back({"mcts_iterations", entry.name, iterations, seconds});
+    }
+    printJson(results);
+    return 0;
+}
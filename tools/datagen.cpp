@@ -0,0 +1,127 @@
+#include "nnue.h"
+#include "selfplay.h"
+#include "trainingdata.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Self-play training data, every thread plays its own games into its own shards
+// A game keeps its samples until the result is known, so memory stays at one game per thread
+namespace {
+
+void printUsage(){
+    std::fprintf(stderr,
+        "Usage: datagen --out PREFIX [--games N] [--samples N] [--threads N] [--config <config>]\n"
+        "               [--openings PLIES] [--temperature PLIES] [--shard-samples N] [--seed N] [--network FILE]\n"
+        "Shards are written as PREFIX-<thread>-<number>.adts, 128 bytes per sample\n"
+        "Config is a match config, the default is iterations=200 with network evaluation if available\n"
+        "With engine=alphabeta the visit distribution of a sample is the chosen move only\n");
+}
+
+}
+
+int main(int argc, char* argv[]){
+    std::string out_prefix;
+    long long max_games = 0;
+    long long max_samples = 0;
+    int threads = 0;
+    std::string config_text;
+    int opening_plies = 4;
+    int temperature_plies = 10;
+    long long shard_samples = 1 << 20;
+    uint32_t seed = 1;
+    std::string network_path;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--out" && has_value) out_prefix = argv[++i];
+        else if(arg == "--games" && has_value) max_games = std::atoll(argv[++i]);
+        else if(arg == "--samples" && has_value) max_samples = std::atoll(argv[++i]);
+        else if(arg == "--threads" && has_value) threads = std::atoi(argv[++i]);
+        else if(arg == "--config" && has_value) config_text = argv[++i];
+        else if(arg == "--openings" && has_value) opening_plies = std::atoi(argv[++i]);
+        else if(arg == "--temperature" && has_value) temperature_plies = std::atoi(argv[++i]);
+        else if(arg == "--shard-samples" && has_value) shard_samples = std::atoll(argv[++i]);
+        else if(arg == "--seed" && has_value) seed = static_cast<uint32_t>(std::atoll(argv[++i]));
+        else if(arg == "--network" && has_value) network_path = argv[++i];
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+    if(out_prefix.empty() || (max_games <= 0 && max_samples <= 0)){
+        printUsage();
+        return 2;
+    }
+
+    AstraDoNetwork::loadDefault(argv[0], network_path);
+
+    PlayerConfig config;
+    config.budget.nodes = 200;
+    // Evaluating leaves is far cheaper than random rollouts, which matters for volume
+    if(AstraDoNetwork::active()) config.mcts.rollout = RolloutType::Evaluation;
+    if(!PlayerConfig::parse(config_text, config)){
+        printUsage();
+        return 2;
+    }
+    if(threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::fprintf(stderr, "config: %s\n", config.toString().c_str());
+
+    std::atomic<long long> next_game{0};
+    std::atomic<long long> samples{0};
+    std::atomic<long long> games{0};
+    std::atomic<int> running{threads};
+    std::atomic<bool> failed{false};
+
+    auto worker = [&](int thread) {
+        TrainingWriter writer;
+        writer.open(out_prefix + "-" + std::to_string(thread), static_cast<uint64_t>(shard_samples));
+        long long game;
+        while(!failed){
+            if(max_samples > 0 && samples >= max_samples) break;
+            game = next_game.fetch_add(1);
+            if(max_games > 0 && game >= max_games) break;
+            // Same games for the same seed, whatever thread plays them
+            std::mt19937 rng(seed * 1000003u + static_cast<uint32_t>(game));
+            AstraDoBoard opening = SelfPlay::randomOpening(opening_plies, rng);
+            long long written = 0;
+            for(const TrainingSample& sample : SelfPlay::playTrainingGame(opening, config, temperature_plies, rng)){
+                if(writer.write(sample)) ++written;
+                else failed = true;
+            }
+            samples += written;
+            ++games;
+        }
+        if(!writer.close()) failed = true;
+        --running;
+    };
+    std::vector<std::thread> pool;
+    for(int t = 0; t < threads; ++t) pool.emplace_back(worker, t);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last_report = start;
+    while(running > 0){
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now - last_report >= std::chrono::seconds(5)){
+            double seconds = std::chrono::duration<double>(now - start).count();
+            std::fprintf(stderr, "%lld games, %lld samples, %.0f samples per hour\n",
+                         games.load(), samples.load(), samples / seconds * 3600);
+            last_report = now;
+        }
+    }
+    for(std::thread& thread : pool) thread.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%lld samples in %.1f s, %.0f samples per hour\n", samples.load(), seconds, samples / seconds * 3600);
+    if(failed){
+        std::fprintf(stderr, "cannot write shards %s-*\n", out_prefix.c_str());
+        return 1;
+    }
+    return 0;
+}
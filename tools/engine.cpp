@@ -0,0 +1,349 @@
+#include "alphabeta.h"
+#include "board.h"
+#include "mcts.h"
+#include "nnue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Headless engine speaking a line-based protocol on stdin/stdout
+// Moves are square numbers 0-53 or "pass", positions use AstraDoBoard::toString
+namespace {
+
+const char* HELP_TEXT =
+    "commands:\n"
+    "  isready                                  answers readyok\n"
+    "  position startpos [moves <m>...]         set up the initial position\n"
+    "  position <board> [moves <m>...]          set up a position, board as printed by show\n"
+    "  play <m>                                 play a move (0-53) or pass\n"
+    "  go [iterations <n>] [time <ms>] [infinite]\n"
+    "                                           search, prints info lines and bestmove\n"
+    "  stop                                     end the search early\n"
+    "  show                                     print the position and legal moves\n"
+    "  stats                                    print statistics of the last search as JSON\n"
+    "  analysis                                 print the latest best moves, also while searching\n"
+    "  setoption <name> <value>                 engine mcts|alphabeta, rollout random|truncated|evaluation,\n"
+    "                                           rootpolicy ucb|halving, rave <k> (0 for off), pns on|off,\n"
+    "                                           memory <MB>, infointerval <ms>, multipv <1-8>\n"
+    "  quit";
+
+class Engine {
+private:
+    AstraDoBoard board;
+
+    std::thread searchThread;
+    std::atomic<bool> searching{false};
+    std::atomic<bool> stopRequested{false};
+    // Whether the running search only ends on stop
+    bool infiniteSearch = false;
+    std::mutex outputMutex;
+
+    // Options
+    SearchAlgorithm algorithm = SearchAlgorithm::MCTS;
+    RolloutType rolloutType = RolloutType::Random;
+    RootPolicy rootPolicy = RootPolicy::UCB;
+    double raveK = 0;
+    bool proofNumberSearch = true;
+    size_t memoryBytes = 0;
+    int infoIntervalMs = 1000;
+    int multiPv = 1;
+
+    // Published by the search thread, read by the command loop
+    AnalysisChannel analysisChannel;
+    AnalysisSnapshot lastAnalysis;
+    // Snapshots are published more often than info lines, so that analysis is fresh
+    static const int ANALYSIS_INTERVAL_MS = 100;
+
+    // Written by the search thread before it clears searching
+    SearchStats lastStats;
+
+    void send(const std::string& line){
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    }
+
+    // Play a move if it is legal in the position
+    static bool playMove(AstraDoBoard& position, const std::string& text){
+        const std::vector<uint8_t>& moves = position.getMoves();
+        if(text == "pass"){
+            // Passing is only allowed without legal moves, and not after the game ended
+            if(!moves.empty() || position.getStale()) return false;
+            position.makeMove(AstraDoGeometry::PASS);
+            return true;
+        }
+        char* end = nullptr;
+        long move = std::strtol(text.c_str(), &end, 10);
+        if(text.empty() || *end != '\0' || move < 0 || move >= AstraDoGeometry::CELLS) return false;
+        if(std::find(moves.begin(), moves.end(), static_cast<uint8_t>(move)) == moves.end()) return false;
+        position.makeMove(static_cast<uint8_t>(move));
+        return true;
+    }
+
+    // Summary line, then one line per root move
+    void sendAnalysis(const AnalysisSnapshot& snapshot){
+        std::ostringstream text;
+        text << "info iterations " << snapshot.iterations << " time " << snapshot.timeMs
+             << " nps " << (snapshot.timeMs > 0 ? snapshot.iterations * 1000 / snapshot.timeMs : 0)
+             << " nodes " << snapshot.treeNodes;
+        for(int i = 0; i < snapshot.lineCount; ++i){
+            const AnalysisLine& line = snapshot.lines[i];
+            text << "\ninfo multipv " << i + 1 << " move " << AstraDoBoard::moveToString(line.move) << " visits " << line.visits
+                 << " winrate " << line.winRate << " score " << line.scoreDiff << " pv";
+            for(int j = 0; j < line.pvLength; ++j) text << " " << AstraDoBoard::moveToString(line.pv[j]);
+        }
+        send(text.str());
+    }
+
+    void waitForSearch(){
+        if(searchThread.joinable()) searchThread.join();
+    }
+
+    void position(std::istringstream& args){
+        std::string token;
+        args >> token;
+        AstraDoBoard next;
+        if(token != "startpos"){
+            // Board is three tokens: squares, side to move and stale flag
+            std::string turn, stale;
+            args >> turn;
+            std::string text = token + " " + turn;
+            std::streampos mark = args.tellg();
+            if(args >> stale && (stale == "0" || stale == "1")) text += " " + stale;
+            else{
+                args.clear();
+                args.seekg(mark);
+            }
+            if(!AstraDoBoard::fromString(text, next)){
+                send("error invalid position");
+                return;
+            }
+        }
+        if(args >> token){
+            if(token != "moves"){
+                send("error expected moves");
+                return;
+            }
+            while(args >> token){
+                if(!playMove(next, token)){
+                    send("error illegal move " + token);
+                    return;
+                }
+            }
+        }
+        board = next;
+    }
+
+    void go(std::istringstream& args){
+        SearchBudget budget;
+        std::string token;
+        bool infinite = false;
+        while(args >> token){
+            if(token == "iterations") args >> budget.nodes;
+            else if(token == "time") args >> budget.timeMs;
+            else if(token == "infinite") infinite = true;
+            else{
+                send("error unknown go argument " + token);
+                return;
+            }
+        }
+        if(board.getMoves().empty() && board.getStale()){
+            send("bestmove none");
+            return;
+        }
+        // Runs until stop, otherwise MCTS uses its default iterations if no limit is given
+        if(infinite) budget.nodes = std::numeric_limits<int>::max();
+        budget.memoryBytes = memoryBytes;
+
+        waitForSearch();
+        // Snapshots of the previous search are dropped
+        analysisChannel.read(lastAnalysis);
+        lastAnalysis = AnalysisSnapshot();
+        stopRequested = false;
+        infiniteSearch = infinite;
+        searching = true;
+        if(algorithm != SearchAlgorithm::MCTS){
+            searchThread = std::thread([this, budget]() { runSearch(budget); });
+            return;
+        }
+        searchThread = std::thread([this, budget]() {
+            MCTS mcts(board, budget);
+            mcts.setRollout(rolloutType);
+            mcts.setRootPolicy(rootPolicy);
+            mcts.setRave(raveK > 0, raveK);
+            mcts.setProofNumberSearch(proofNumberSearch);
+            mcts.setStopFlag(&stopRequested);
+            mcts.setAnalysis(&analysisChannel, multiPv, ANALYSIS_INTERVAL_MS);
+            // Called on this thread, so the tree can be read directly
+            mcts.setInfoCallback([this, &mcts](const MCTSInfo&) {
+                sendAnalysis(mcts.getAnalysis(multiPv));
+            }, infoIntervalMs);
+            uint8_t move = mcts.getBestMove();
+            lastStats = mcts.getStats();
+            // Commands sent in reply to bestmove must not see a running search
+            searching = false;
+            send("bestmove " + AstraDoBoard::moveToString(move));
+        });
+    }
+
+    // Search of an engine without a tree, which only reports its result
+    void runSearch(const SearchBudget& budget){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::unique_ptr<SearchEngine> engine = createSearchEngine(algorithm, board, budget);
+        engine->setStopFlag(&stopRequested);
+        uint8_t move = engine->getBestMove();
+        SearchStats stats;
+        stats.iterations = engine->getNodeCount();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        lastStats = stats;
+        std::ostringstream text;
+        text << "info nodes " << stats.iterations << " time " << static_cast<long long>(stats.seconds * 1000);
+        if(AlphaBetaSearch* search = dynamic_cast<AlphaBetaSearch*>(engine.get())){
+            text << " depth " << search->getDepth() << " score " << search->getScore();
+        }
+        send(text.str());
+        searching = false;
+        send("bestmove " + AstraDoBoard::moveToString(move));
+    }
+
+    void show(){
+        send("position " + board.toString());
+        std::string moves = "moves";
+        for(uint8_t move : board.getMoves()) moves += " " + std::to_string(move);
+        if(board.getMoves().empty()) moves += board.getStale() ? " none" : " pass";
+        send(moves);
+        if(board.getMoves().empty() && board.getStale()){
+            std::pair<int, int> piece_count = board.getPieceCount();
+            send("result " + std::to_string(piece_count.first) + "-" + std::to_string(piece_count.second));
+        }
+    }
+
+    void setOption(std::istringstream& args){
+        std::string name, value;
+        args >> name >> value;
+        if(name == "engine"){
+            if(!parseSearchAlgorithm(value, algorithm)) send("error unknown option " + name + " " + value);
+        }
+        else if(name == "rollout" && value == "random") rolloutType = RolloutType::Random;
+        else if(name == "rollout" && value == "truncated") rolloutType = RolloutType::Truncated;
+        else if(name == "rollout" && value == "evaluation") rolloutType = RolloutType::Evaluation;
+        else if(name == "rootpolicy" && value == "ucb") rootPolicy = RootPolicy::UCB;
+        else if(name == "rootpolicy" && value == "halving") rootPolicy = RootPolicy::SequentialHalving;
+        else if(name == "rave") raveK = std::max(0.0, std::atof(value.c_str()));
+        else if(name == "pns" && value == "on") proofNumberSearch = true;
+        else if(name == "pns" && value == "off") proofNumberSearch = false;
+        else if(name == "memory") memoryBytes = static_cast<size_t>(std::atoll(value.c_str())) << 20;
+        else if(name == "infointerval") infoIntervalMs = std::atoi(value.c_str());
+        else if(name == "multipv") multiPv = std::max(1, std::min(ANALYSIS_MAX_LINES, std::atoi(value.c_str())));
+        else send("error unknown option " + name + " " + value);
+    }
+
+public:
+    Engine(){
+        // A loaded network is both cheaper and more accurate than a random rollout
+        if(AstraDoNetwork::active()) rolloutType = RolloutType::Evaluation;
+    }
+
+    ~Engine(){
+        stopRequested = true;
+        waitForSearch();
+    }
+
+    // End of input, a limited search is finished so that scripts get their bestmove
+    void finish(){
+        if(infiniteSearch) stopRequested = true;
+        waitForSearch();
+    }
+
+    // Handle one command, returns false on quit
+    bool handle(const std::string& line){
+        std::istringstream args(line);
+        std::string command;
+        if(!(args >> command)) return true;
+
+        if(command == "quit"){
+            return false;
+        }
+        else if(command == "stop"){
+            stopRequested = true;
+            waitForSearch();
+        }
+        else if(command == "isready"){
+            send("readyok");
+        }
+        else if(command == "help"){
+            send(HELP_TEXT);
+        }
+        else if(command == "analysis"){
+            // Never waits for the search, the latest published snapshot is shown
+            analysisChannel.read(lastAnalysis);
+            if(lastAnalysis.sequence == 0) send("error no analysis");
+            else sendAnalysis(lastAnalysis);
+        }
+        else if(searching){
+            // The position must not change under a running search
+            send("error busy");
+        }
+        else if(command == "position"){
+            position(args);
+        }
+        else if(command == "play"){
+            std::string move;
+            args >> move;
+            if(!playMove(board, move)) send("error illegal move " + move);
+        }
+        else if(command == "go"){
+            go(args);
+        }
+        else if(command == "show"){
+            show();
+        }
+        else if(command == "stats"){
+            send("stats " + lastStats.toJson());
+        }
+        else if(command == "setoption"){
+            setOption(args);
+        }
+        else{
+            send("error unknown command " + command);
+        }
+        return true;
+    }
+};
+
+}
+
+int main(int argc, char* argv[]){
+    std::string network_path;
+    std::string trace_path;
+    for(int i = 1; i < argc; ++i){
+        if(std::string(argv[i]) == "--network" && i + 1 < argc) network_path = argv[++i];
+        else if(std::string(argv[i]) == "--trace" && i + 1 < argc) trace_path = argv[++i];
+    }
+    AstraDoNetwork::loadDefault(argv[0], network_path);
+    // Timelines are only recorded by a build with ASTRADO_INSTRUMENTATION
+    if(!trace_path.empty()) SearchTrace::start(trace_path);
+
+    {
+        Engine engine;
+        std::string line;
+        bool quit = false;
+        while(!quit && std::getline(std::cin, line)){
+            quit = !engine.handle(line);
+        }
+        if(!quit) engine.finish();
+    }
+    if(!trace_path.empty() && !SearchTrace::stop()) std::fprintf(stderr, "cannot write trace %s\n", trace_path.c_str());
+    return 0;
+}
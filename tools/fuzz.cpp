@@ -0,0 +1,238 @@
+#include "board.h"
+#include "referenceboard.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Differential test of the board against the reference model
+// Random games are played through both, and moves, flips, turn, stale flag and pieces are compared after every ply
+namespace {
+
+void printUsage(){
+    std::printf(
+        "Usage: fuzz [--games N] [--seed S] [--side N] [--threads N]\n"
+        "Side: triangles along every edge of the board, 3 for the standard board (default), 4 to 6 for larger variants\n"
+        "On a divergence the game is shrunk to a short line that still diverges, and the exit code is 1\n");
+}
+
+// Result of playing a line through both boards
+struct LineResult {
+    // Ply after which the boards differ, -1 if they agree throughout
+    int divergence = -1;
+    // The line is not legal for the reference model
+    bool illegal = false;
+    std::string difference;
+    // Reference position before the diverging ply
+    std::string position;
+};
+
+template<class Geometry>
+std::string movesText(const std::vector<uint8_t>& moves){
+    std::string text;
+    for(uint8_t move : moves){
+        if(!text.empty()) text += ' ';
+        text += BasicBoard<Geometry>::moveToString(move);
+    }
+    return text.empty() ? "none" : text;
+}
+
+// First difference between the boards, empty if they agree
+// flips are the squares the board flipped on the last move
+template<class Geometry>
+std::string compare(const BasicBoard<Geometry>& board, const BasicReferenceBoard<Geometry>& reference, const std::vector<uint8_t>& flips){
+    if(board.getTurn() != reference.getTurn()) return "turn differs";
+    if(board.getStale() != reference.getStale()) return "stale flag differs";
+    if(flips != reference.getFlips()){
+        return "flips " + movesText<Geometry>(flips) + ", reference " + movesText<Geometry>(reference.getFlips());
+    }
+    if(board.getPieceCount() != reference.getPieceCount()){
+        std::pair<int, int> count = board.getPieceCount();
+        std::pair<int, int> expected = reference.getPieceCount();
+        return "pieces " + std::to_string(count.first) + "/" + std::to_string(count.second) +
+               ", reference " + std::to_string(expected.first) + "/" + std::to_string(expected.second);
+    }
+    if(board.toString() != reference.toString()) return "position " + board.toString() + ", reference " + reference.toString();
+    if(board.getMoves() != reference.getMoves()){
+        return "moves " + movesText<Geometry>(board.getMoves()) + ", reference " + movesText<Geometry>(reference.getMoves());
+    }
+    return "";
+}
+
+// Play line from the initial position through both boards
+// With rng the line is extended by random reference moves until the game is over
+template<class Geometry>
+LineResult playLine(std::vector<uint8_t>& line, std::mt19937_64* rng){
+    using Board = BasicBoard<Geometry>;
+    LineResult result;
+    Board board;
+    BasicReferenceBoard<Geometry> reference;
+    std::vector<uint8_t> flips;
+    result.difference = compare(board, reference, flips);
+    if(!result.difference.empty()){
+        result.divergence = 0;
+        result.position = reference.toString();
+        return result;
+    }
+
+    for(size_t ply = 0; ; ++ply){
+        const std::vector<uint8_t>& moves = reference.getMoves();
+        if(moves.empty() && reference.getStale()){
+            // Game over, a longer line cannot be played
+            result.illegal = ply < line.size();
+            return result;
+        }
+        if(ply == line.size()){
+            if(!rng) return result;
+            line.push_back(moves.empty() ? Geometry::PASS : moves[(*rng)() % moves.size()]);
+        }
+        uint8_t move = line[ply];
+        bool legal = moves.empty() ? move == Geometry::PASS : std::binary_search(moves.begin(), moves.end(), move);
+        if(!legal){
+            result.illegal = true;
+            return result;
+        }
+
+        std::string position = reference.toString();
+        // Squares of the opponent that belong to the side to move afterwards
+        typename Board::Bits before = board.getTurn() ? board.getWhitePieces() : board.getBlackPieces();
+        bool mover = board.getTurn();
+        board.makeMove(move);
+        reference.makeMove(move);
+        flips.clear();
+        if(move < Geometry::CELLS){
+            (before & (mover ? board.getBlackPieces() : board.getWhitePieces())).forEach([&flips](int pos) {
+                flips.push_back(static_cast<uint8_t>(pos));
+            });
+        }
+
+        result.difference = compare(board, reference, flips);
+        if(!result.difference.empty()){
+            result.divergence = static_cast<int>(ply) + 1;
+            result.position = position;
+            line.resize(ply + 1);
+            return result;
+        }
+    }
+}
+
+// Drop moves from a diverging line as long as it stays legal and still diverges
+template<class Geometry>
+LineResult minimize(std::vector<uint8_t>& line){
+    LineResult best = playLine<Geometry>(line, nullptr);
+    bool shrunk = true;
+    while(shrunk){
+        shrunk = false;
+        for(size_t i = 0; i < line.size(); ++i){
+            std::vector<uint8_t> shorter(line);
+            shorter.erase(shorter.begin() + i);
+            LineResult result = playLine<Geometry>(shorter, nullptr);
+            if(result.illegal || result.divergence < 0) continue;
+            line = shorter;
+            best = result;
+            shrunk = true;
+            break;
+        }
+    }
+    return best;
+}
+
+template<class Geometry>
+int fuzz(long long games, unsigned long long seed, int threads){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<long long> next_game{0};
+    std::atomic<long long> total_plies{0};
+    std::atomic<bool> diverged{false};
+    std::mutex mutex;
+    long long diverged_game = -1;
+    std::vector<uint8_t> diverged_line;
+
+    // Every thread takes the next game that is not played yet, every game has its own seed
+    auto worker = [&]() {
+        long long game;
+        std::vector<uint8_t> line;
+        while(!diverged && (game = next_game.fetch_add(1)) < games){
+            std::mt19937_64 rng(seed + static_cast<unsigned long long>(game));
+            line.clear();
+            LineResult result = playLine<Geometry>(line, &rng);
+            total_plies += static_cast<long long>(line.size());
+            if(result.divergence >= 0){
+                std::lock_guard<std::mutex> lock(mutex);
+                if(diverged_game < 0 || game < diverged_game){
+                    diverged_game = game;
+                    diverged_line = line;
+                }
+                diverged = true;
+            }
+        }
+    };
+    if(threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for(int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for(std::thread& thread : pool) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if(diverged_game < 0){
+        std::printf("%lld games, %lld plies, all boards agree in %.3f s, %.0f plies per second\n",
+                    games, total_plies.load(), seconds, seconds > 0 ? total_plies / seconds : 0);
+        return 0;
+    }
+
+    LineResult found = playLine<Geometry>(diverged_line, nullptr);
+    std::printf("divergence in game %lld (seed %llu) after ply %d: %s\n",
+                diverged_game, seed + static_cast<unsigned long long>(diverged_game), found.divergence, found.difference.c_str());
+    LineResult minimal = minimize<Geometry>(diverged_line);
+    std::printf("shrunk to %zu plies: %s\n", diverged_line.size(), movesText<Geometry>(diverged_line).c_str());
+    std::printf("difference: %s\n", minimal.difference.c_str());
+    if(minimal.divergence > 0){
+        std::printf("position before the last ply: %s\n", minimal.position.c_str());
+        std::printf("last ply: %s\n", BasicBoard<Geometry>::moveToString(diverged_line.back()).c_str());
+    }
+    return 1;
+}
+
+}
+
+int main(int argc, char* argv[]){
+    long long games = 100000;
+    unsigned long long seed = 1;
+    int side = 3;
+    int threads = 0;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--games" && has_value){
+            games = std::atoll(argv[++i]);
+        }
+        else if(arg == "--seed" && has_value){
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--side" && has_value){
+            side = std::atoi(argv[++i]);
+        }
+        else if(arg == "--threads" && has_value){
+            threads = std::atoi(argv[++i]);
+        }
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+
+    switch(side){
+    case 3: return fuzz<AstraDoGeometry>(games, seed, threads);
+    case 4: return fuzz<HexGeometry<4>>(games, seed, threads);
+    case 5: return fuzz<HexGeometry<5>>(games, seed, threads);
+    case 6: return fuzz<HexGeometry<6>>(games, seed, threads);
+    default:
+        printUsage();
+        return 2;
+    }
+}
@@ -0,0 +1,154 @@
+#include "nnue.h"
+#include "selfplay.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Engine match between two engine configurations, A and B
+// Every opening is played twice with colours swapped; results are from A's point of view
+namespace {
+
+void printUsage(){
+    std::printf(
+        "Usage: match --a <config> --b <config> [--games N] [--threads N] [--openings PLIES]\n"
+        "             [--seed N] [--sprt ELO0 ELO1] [--alpha A] [--beta B] [--out FILE] [--network FILE]\n"
+        "Config: key=value list separated by commas, keys: engine (mcts|alphabeta), iterations, time, c, minvisits,\n"
+        "        rollout (random|truncated|evaluation), plies, rootpolicy (ucb|halving),\n"
+        "        rave (RAVE weight k, 0 for off), pns (on|off)\n");
+}
+
+struct Totals {
+    MatchScore score;
+    // Effort of A and B
+    long long iterations[2] = {0, 0};
+    double seconds[2] = {0, 0};
+};
+
+}
+
+int main(int argc, char* argv[]){
+    PlayerConfig players[2];
+    int games = 100;
+    int threads = 0;
+    int opening_plies = 4;
+    uint32_t seed = 1;
+    double elo0 = 0, elo1 = 10, alpha = 0.05, beta = 0.05;
+    bool sprt = false;
+    std::string out_path;
+    std::string network_path;
+    bool has_a = false, has_b = false;
+
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--a" && has_value) has_a = PlayerConfig::parse(argv[++i], players[0]);
+        else if(arg == "--b" && has_value) has_b = PlayerConfig::parse(argv[++i], players[1]);
+        else if(arg == "--games" && has_value) games = std::atoi(argv[++i]);
+        else if(arg == "--threads" && has_value) threads = std::atoi(argv[++i]);
+        else if(arg == "--openings" && has_value) opening_plies = std::atoi(argv[++i]);
+        else if(arg == "--seed" && has_value) seed = static_cast<uint32_t>(std::atoll(argv[++i]));
+        else if(arg == "--sprt" && i + 2 < argc){
+            sprt = true;
+            elo0 = std::atof(argv[++i]);
+            elo1 = std::atof(argv[++i]);
+        }
+        else if(arg == "--alpha" && has_value) alpha = std::atof(argv[++i]);
+        else if(arg == "--beta" && has_value) beta = std::atof(argv[++i]);
+        else if(arg == "--out" && has_value) out_path = argv[++i];
+        else if(arg == "--network" && has_value) network_path = argv[++i];
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+    if(!has_a || !has_b){
+        printUsage();
+        return 2;
+    }
+    // rollout=evaluation needs the network
+    AstraDoNetwork::loadDefault(argv[0], network_path);
+    if(threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    int pairs = (games + 1) / 2;
+
+    std::ofstream out;
+    if(!out_path.empty()){
+        out.open(out_path);
+        out << "# A: " << players[0].toString() << "\n# B: " << players[1].toString() << "\n";
+    }
+    std::printf("A: %s\nB: %s\n", players[0].toString().c_str(), players[1].toString().c_str());
+    if(sprt){
+        std::printf("SPRT elo0 %.1f elo1 %.1f, bounds %.2f %.2f\n", elo0, elo1,
+                    MatchScore::lowerBound(alpha, beta), MatchScore::upperBound(alpha, beta));
+    }
+
+    Totals totals;
+    std::mutex mutex;
+    std::atomic<int> next_pair{0};
+    std::atomic<bool> finished{false};
+    std::string verdict;
+
+    auto worker = [&]() {
+        int pair;
+        while(!finished && (pair = next_pair.fetch_add(1)) < pairs){
+            std::mt19937 rng(seed * 1000003u + static_cast<uint32_t>(pair));
+            AstraDoBoard opening = SelfPlay::randomOpening(opening_plies, rng);
+            for(int a_side = 0; a_side < 2 && !finished; ++a_side){
+                // a_side 0: A plays black
+                const PlayerConfig& black = a_side == 0 ? players[0] : players[1];
+                const PlayerConfig& white = a_side == 0 ? players[1] : players[0];
+                GameRecord game = SelfPlay::playGame(opening, black, white, rng());
+
+                int diff = game.blackPieces - game.whitePieces;
+                if(a_side == 1) diff = -diff;
+                std::lock_guard<std::mutex> lock(mutex);
+                if(diff > 0) ++totals.score.wins;
+                else if(diff < 0) ++totals.score.losses;
+                else ++totals.score.draws;
+                for(int color = 0; color < 2; ++color){
+                    // Colour 0 is black, A is black when a_side is 0
+                    int player = color == a_side ? 0 : 1;
+                    totals.iterations[player] += game.iterations[color];
+                    totals.seconds[player] += game.seconds[color];
+                }
+                if(out.is_open()){
+                    out << (a_side == 0 ? "A-B " : "B-A ") << SelfPlay::formatGame(game) << "\n";
+                }
+
+                const MatchScore& score = totals.score;
+                std::printf("games %d: +%d =%d -%d  score %.1f%%  elo %.1f +- %.1f",
+                            score.games(), score.wins, score.draws, score.losses,
+                            100 * score.score(), score.elo(), score.eloError());
+                if(sprt){
+                    double llr = score.llr(elo0, elo1);
+                    std::printf("  llr %.2f", llr);
+                    if(verdict.empty() && llr >= MatchScore::upperBound(alpha, beta)) verdict = "H1 accepted (A is stronger)";
+                    if(verdict.empty() && llr <= MatchScore::lowerBound(alpha, beta)) verdict = "H0 accepted (A is not stronger)";
+                    if(!verdict.empty()) finished = true;
+                }
+                std::printf("\n");
+                std::fflush(stdout);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for(int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for(std::thread& thread : pool) thread.join();
+
+    const MatchScore& score = totals.score;
+    std::printf("\nA vs B: +%d =%d -%d, elo %.1f +- %.1f\n", score.wins, score.draws, score.losses, score.elo(), score.eloError());
+    for(int player = 0; player < 2; ++player){
+        std::printf("%c: %.0f iterations/s, %.1f s thinking\n", player == 0 ? 'A' : 'B',
+                    totals.seconds[player] > 0 ? totals.iterations[player] / totals.seconds[player] : 0,
+                    totals.seconds[player]);
+    }
+    if(sprt) std::printf("SPRT: %s\n", verdict.empty() ? "no decision yet" : verdict.c_str());
+    return 0;
+}
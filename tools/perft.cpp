@@ -0,0 +1,205 @@
+#include "board.h"
+#include "perft.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct KnownCount {
+    const char* name;
+    // Empty for the initial position
+    const char* position;
+    int depth;
+    long long nodes;
+};
+
+// Counts of the current move generator, a rewrite has to reproduce them exactly
+// The positions cover the opening, the middle game, a forced pass and the end of the game
+const KnownCount known_counts[] = {
+    {"initial", "", 1, 3},
+    {"initial", "", 5, 918},
+    {"initial", "", 8, 58488},
+    {"initial", "", 10, 1161384},
+    {"middle", "wbwwbb.wwbbbw.....b........b.b......w.w......w.bb..... b 0", 6, 21621},
+    {"middle", "wbwwbb.wwbbbw.....b........b.b......w.w......w.bb..... b 0", 9, 3224037},
+    {"late", "bwbwbwwwwbwww...bbbbbbbb...b.ww.....bbbw.b...b.ww..bb. b 0", 5, 8077},
+    {"late", "bwbwbwwwwbwww...bbbbbbbb...b.ww.....bbbw.b...b.ww..bb. b 0", 8, 1421998},
+    {"pass", "bbb......b........b.bb.....bbbb.b.b.wwwwwwwwwbbbb..... b 0", 3, 12},
+    {"pass", "bbb......b........b.bb.....bbbb.b.b.wwwwwwwwwbbbb..... b 0", 11, 2431357},
+    {"endgame", "bbbwbbw..bwww.b.w.bwww.wwb.wwwb.w.bbwbbbbbbbwwwwwwwwww w 0", 8, 2785},
+    {"endgame", "bbbwbbw..bwww.b.w.bwww.wwb.wwwb.w.bbwbbbbbbbwwwwwwwwww w 0", 12, 122},
+    {"endgame", "bbbwbbw..bwww.b.w.bwww.wwb.wwwb.w.bbwbbbbbbbwwwwwwwwww w 0", 14, 0},
+};
+
+struct GeneratedCount {
+    int side;
+    const char* name;
+    // Empty for the initial position
+    const char* position;
+    int depth;
+    long long nodes;
+};
+
+// Counts of generated boards, side 3 is the standard board under another numbering
+// From the initial position play stays in the middle for many plies, so every side also has a rim position:
+// next to both ends of every line a white piece and then a black one, black to move onto the edge and corner cells
+// These counts agree with the reference model
+const GeneratedCount generated_counts[] = {
+    {3, "hex3", "", 8, 58488},
+    {3, "hex3", "", 10, 1161384},
+    {3, "hex3 rim", "wwb.bww.wbb.bbw.wwb.....bwwwwb.....bww.wbb.bbw.wwb.bww b 0", 7, 34332},
+    {4, "hex4", "", 10, 1168452},
+    {4, "hex4 rim", "wwb.w.bww.wbb.b.bbw..wb.......bw.wwb.........bwwwwb.........bww.wb.......bw..wbb.b.bbw.wwb.w.bww b 0",
+     6, 3976320},
+    {5, "hex5", "", 9, 255846},
+    {5, "hex5 rim",
+     "wwb.w.w.bww.wbb.b.b.bbw..wb.........bw..wb...........bw.wwb.............bwwwwb............."
+     "bww.wb...........bw..wb.........bw..wbb.b.b.bbw.wwb.w.w.bww b 0",
+     5, 1910840},
+    {6, "hex6", "", 9, 255846},
+    {6, "hex6 rim",
+     "wwb.w.w.w.bww.wbb.b.b.b.bbw..wb...........bw..wb.............bw..wb...............bw.wwb................."
+     "bwwwwb.................bww.wb...............bw..wb.............bw..wb...........bw..wbb.b.b.b.bbw.wwb.w.w.w.bww b 0",
+     5, 7811496},
+};
+
+void printUsage(){
+    std::printf(
+        "Usage: perft [depth] [--side N] [--position \"<board>\"] [--threads N] [--divide]\n"
+        "       perft --verify [--threads N]\n"
+        "Side: triangles along every edge of the board, 3 for the standard board (default), 4 to 6 for larger variants\n"
+        "Board: 6 * side^2 squares (b, w or .), side to move (b or w) and stale flag (0 or 1)\n");
+}
+
+void printResult(int depth, const PerftResult& result){
+    std::printf("depth %d nodes %lld time %.3f s nps %.0f\n", depth, result.nodes, result.seconds, result.nodesPerSecond());
+}
+
+// Every cell of a geometry has to lie on one line of each direction
+template<class Geometry>
+bool verifyTables(const char* name){
+    const GeometryTables& tables = Geometry::tables();
+    bool ok = static_cast<int>(tables.lines.size()) == Geometry::LINES &&
+              static_cast<int>(tables.squares.size()) == Geometry::CELLS;
+    for(int cell = 0; ok && cell < Geometry::CELLS; ++cell){
+        for(int direction = 0; direction < 3; ++direction){
+            const std::array<uint8_t, 2>& square = tables.squares[cell][direction];
+            ok = ok && square[0] / (Geometry::LINES / 3) == direction && tables.lines[square[0]][square[1]] == cell;
+        }
+    }
+    std::printf("%-8s tables %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+template<class Geometry>
+bool verifyCount(const KnownCount& known, int threads, long long& total_nodes, double& total_seconds){
+    using Board = BasicBoard<Geometry>;
+    Board board;
+    if(known.position[0] && !Board::fromString(known.position, board)){
+        std::printf("%-8s bad position\n", known.name);
+        return false;
+    }
+    PerftResult result = BasicPerft<Geometry>::run(board, known.depth, threads);
+    bool ok = result.nodes == known.nodes;
+    total_nodes += result.nodes;
+    total_seconds += result.seconds;
+    std::printf("%-8s depth %2d nodes %10lld expected %10lld %s  %.3f s\n",
+                known.name, known.depth, result.nodes, known.nodes, ok ? "ok" : "FAILED", result.seconds);
+    return ok;
+}
+
+int verify(int threads){
+    int failed = 0;
+    long long total_nodes = 0;
+    double total_seconds = 0;
+    for(const KnownCount& known : known_counts){
+        if(!verifyCount<AstraDoGeometry>(known, threads, total_nodes, total_seconds)) ++failed;
+    }
+    if(!verifyTables<AstraDoGeometry>("standard")) ++failed;
+    if(!verifyTables<HexGeometry<3>>("hex3")) ++failed;
+    if(!verifyTables<HexGeometry<4>>("hex4")) ++failed;
+    if(!verifyTables<HexGeometry<5>>("hex5")) ++failed;
+    if(!verifyTables<HexGeometry<6>>("hex6")) ++failed;
+    for(const GeneratedCount& generated : generated_counts){
+        KnownCount known = {generated.name, generated.position, generated.depth, generated.nodes};
+        bool ok = false;
+        switch(generated.side){
+        case 3: ok = verifyCount<HexGeometry<3>>(known, threads, total_nodes, total_seconds); break;
+        case 4: ok = verifyCount<HexGeometry<4>>(known, threads, total_nodes, total_seconds); break;
+        case 5: ok = verifyCount<HexGeometry<5>>(known, threads, total_nodes, total_seconds); break;
+        case 6: ok = verifyCount<HexGeometry<6>>(known, threads, total_nodes, total_seconds); break;
+        }
+        if(!ok) ++failed;
+    }
+    std::printf("%s, %lld nodes in %.3f s, nps %.0f\n", failed ? "FAILED" : "all counts match",
+                total_nodes, total_seconds, total_seconds > 0 ? total_nodes / total_seconds : 0);
+    return failed ? 1 : 0;
+}
+
+// Run perft on the board of one geometry, position is empty for the initial position
+template<class Geometry>
+int runPerft(const char* position, int depth, int threads, bool divide){
+    using Board = BasicBoard<Geometry>;
+    Board board;
+    if(position && !Board::fromString(position, board)){
+        std::fprintf(stderr, "Invalid position: %s\n", position);
+        return 2;
+    }
+    PerftResult result = BasicPerft<Geometry>::run(board, depth, threads);
+    if(divide){
+        for(const std::pair<uint8_t, long long>& entry : result.divide){
+            std::printf("%2d: %lld\n", static_cast<int>(entry.first), entry.second);
+        }
+    }
+    printResult(depth, result);
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[]){
+    int depth = 6;
+    int threads = 0;
+    int side = 3;
+    bool divide = false;
+    bool check = false;
+    const char* position = nullptr;
+    for(int i = 1; i < argc; ++i){
+        if(std::strcmp(argv[i], "--verify") == 0){
+            check = true;
+        }
+        else if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            threads = std::atoi(argv[++i]);
+        }
+        else if(std::strcmp(argv[i], "--side") == 0 && i + 1 < argc){
+            side = std::atoi(argv[++i]);
+        }
+        else if(std::strcmp(argv[i], "--position") == 0 && i + 1 < argc){
+            position = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--divide") == 0){
+            divide = true;
+        }
+        else if(argv[i][0] != '-' && std::atoi(argv[i]) > 0){
+            depth = std::atoi(argv[i]);
+        }
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+
+    if(check) return verify(threads);
+
+    switch(side){
+    case 3: return runPerft<AstraDoGeometry>(position, depth, threads, divide);
+    case 4: return runPerft<HexGeometry<4>>(position, depth, threads, divide);
+    case 5: return runPerft<HexGeometry<5>>(position, depth, threads, divide);
+    case 6: return runPerft<HexGeometry<6>>(position, depth, threads, divide);
+    default:
+        printUsage();
+        return 2;
+    }
+}
@@ -0,0 +1,401 @@
+#include "nnue.h"
+#include "selfplay.h"
+#include "sessionpool.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Engine server on a local socket, many games share one pool of search threads
+// Every connection speaks a line-based protocol; a session belongs to the connection that opened it
+// and is closed with it. Replies to go come later, so every reply starts with the session id
+namespace {
+
+void printUsage(){
+    std::fprintf(stderr,
+        "Usage: server [--socket PATH] [--threads N] [--memory MB] [--config <config>] [--network FILE]\n"
+        "The default socket is astrado.sock, memory is the budget of all search trees together\n");
+}
+
+const char* HELP_TEXT =
+    "commands:\n"
+    "  new [startpos|<board>]                   open a session, answers session <id>\n"
+    "  position <id> startpos|<board> [moves <m>...]\n"
+    "                                           set up a position, the tree is discarded\n"
+    "  play <id> <m>                            play a move (0-53) or pass, the tree below it is kept\n"
+    "  go <id> [iterations <n>] [time <ms>]     search, answers bestmove <id> <m> once done\n"
+    "  stop <id>                                end the search early\n"
+    "  show <id>                                print the position of the session\n"
+    "  close <id>                               close the session\n"
+    "  status                                   sessions, searches and memory of the server\n"
+    "  quit";
+
+std::atomic<bool> shutdownRequested{false};
+
+void handleSignal(int){
+    shutdownRequested = true;
+}
+
+std::string resultToString(SessionResult result){
+    switch(result){
+    case SessionResult::UnknownSession: return "unknown session";
+    case SessionResult::Busy: return "busy";
+    case SessionResult::IllegalMove: return "illegal move";
+    case SessionResult::GameOver: return "game over";
+    default: return "ok";
+    }
+}
+
+// Board is three tokens (squares, side to move and optional stale flag) or startpos
+bool readBoard(std::istringstream& args, AstraDoBoard& board){
+    std::string token;
+    board = AstraDoBoard();
+    if(!(args >> token) || token == "startpos") return true;
+    std::string turn, stale;
+    args >> turn;
+    std::string text = token + " " + turn;
+    std::streampos mark = args.tellg();
+    if(args >> stale && (stale == "0" || stale == "1")) text += " " + stale;
+    else{
+        args.clear();
+        args.seekg(mark);
+    }
+    return AstraDoBoard::fromString(text, board);
+}
+
+bool readMove(const std::string& text, uint8_t& move){
+    if(text == "pass"){
+        move = AstraDoGeometry::PASS;
+        return true;
+    }
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if(text.empty() || *end != '\0' || value < 0 || value >= AstraDoGeometry::CELLS) return false;
+    move = static_cast<uint8_t>(value);
+    return true;
+}
+
+class Connection {
+private:
+    int socket;
+    SessionPool& pool;
+    // Replies of finished searches are written from worker threads
+    std::mutex outputMutex;
+    bool open = true;
+    std::set<int> ownSessions;
+
+    bool readId(std::istringstream& args, int& id){
+        if(!(args >> id) || !ownSessions.count(id)){
+            send("error unknown session");
+            return false;
+        }
+        return true;
+    }
+
+    void reply(int id, SessionResult result){
+        if(result != SessionResult::Ok) send("error " + std::to_string(id) + " " + resultToString(result));
+    }
+
+    void position(std::istringstream& args){
+        int id;
+        if(!readId(args, id)) return;
+        AstraDoBoard board;
+        if(!readBoard(args, board)){
+            send("error " + std::to_string(id) + " invalid position");
+            return;
+        }
+        std::string token;
+        if(args >> token){
+            if(token != "moves"){
+                send("error " + std::to_string(id) + " expected moves");
+                return;
+            }
+            while(args >> token){
+                uint8_t move;
+                const std::vector<uint8_t>& moves = board.getMoves();
+                bool legal = readMove(token, move) &&
+                    (move >= AstraDoGeometry::PASS ? moves.empty() && !board.getStale() : std::find(moves.begin(), moves.end(), move) != moves.end());
+                if(!legal){
+                    send("error " + std::to_string(id) + " illegal move " + token);
+                    return;
+                }
+                board.makeMove(move);
+            }
+        }
+        reply(id, pool.setPosition(id, board));
+    }
+
+    void go(std::istringstream& args){
+        int id;
+        if(!readId(args, id)) return;
+        SearchBudget budget;
+        std::string token;
+        while(args >> token){
+            if(token == "iterations") args >> budget.nodes;
+            else if(token == "time") args >> budget.timeMs;
+            else{
+                send("error " + std::to_string(id) + " unknown go argument " + token);
+                return;
+            }
+        }
+        std::weak_ptr<Connection> self = weakSelf;
+        SessionResult result = pool.search(id, budget, [self](int session, uint8_t move, long long iterations) {
+            // Connection may be gone by the time the search ends
+            if(std::shared_ptr<Connection> connection = self.lock()){
+                connection->send("bestmove " + std::to_string(session) + " " + AstraDoBoard::moveToString(move) +
+                                 " iterations " + std::to_string(iterations));
+            }
+        });
+        reply(id, result);
+    }
+
+    void show(std::istringstream& args){
+        int id;
+        if(!readId(args, id)) return;
+        AstraDoBoard board;
+        SessionResult result = pool.getPosition(id, board);
+        if(result != SessionResult::Ok){
+            reply(id, result);
+            return;
+        }
+        std::string moves;
+        for(uint8_t move : board.getMoves()) moves += " " + std::to_string(move);
+        if(board.getMoves().empty()) moves += board.getStale() ? " none" : " pass";
+        send("position " + std::to_string(id) + " " + board.toString() + " moves" + moves);
+    }
+
+    void status(){
+        SessionPoolStatus status = pool.getStatus();
+        send("status sessions " + std::to_string(status.sessions) + " searching " + std::to_string(status.searching) +
+             " memory " + std::to_string(status.memoryBytes >> 10) + "K limit " +
+             std::to_string(status.sessionMemoryLimit >> 10) + "K");
+    }
+
+public:
+    // Set by the owner, callbacks only hold the connection weakly
+    std::weak_ptr<Connection> weakSelf;
+
+    Connection(int socket_fd, SessionPool& session_pool) :
+        socket(socket_fd),
+        pool(session_pool){
+    }
+
+    ~Connection(){
+        ::close(socket);
+    }
+
+    void send(const std::string& line){
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if(!open) return;
+        std::string text = line + "\n";
+        size_t sent = 0;
+        while(sent < text.size()){
+            // No SIGPIPE if the client has gone away
+            ssize_t n = ::send(socket, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0){
+                open = false;
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    // Wake up the reading thread, used on shutdown
+    void interrupt(){
+        ::shutdown(socket, SHUT_RDWR);
+    }
+
+    // Handle one command, returns false on quit
+    bool handle(const std::string& line){
+        std::istringstream args(line);
+        std::string command;
+        if(!(args >> command)) return true;
+
+        if(command == "quit"){
+            return false;
+        }
+        else if(command == "help"){
+            send(HELP_TEXT);
+        }
+        else if(command == "new"){
+            AstraDoBoard board;
+            if(!readBoard(args, board)){
+                send("error invalid position");
+                return true;
+            }
+            int id = pool.createSession(board);
+            ownSessions.insert(id);
+            send("session " + std::to_string(id));
+        }
+        else if(command == "position"){
+            position(args);
+        }
+        else if(command == "play"){
+            int id;
+            std::string token;
+            if(!readId(args, id)) return true;
+            uint8_t move;
+            args >> token;
+            if(!readMove(token, move)) send("error " + std::to_string(id) + " illegal move " + token);
+            else reply(id, pool.playMove(id, move));
+        }
+        else if(command == "go"){
+            go(args);
+        }
+        else if(command == "stop"){
+            int id;
+            if(readId(args, id)) reply(id, pool.stop(id));
+        }
+        else if(command == "show"){
+            show(args);
+        }
+        else if(command == "close"){
+            int id;
+            if(!readId(args, id)) return true;
+            ownSessions.erase(id);
+            reply(id, pool.closeSession(id));
+        }
+        else if(command == "status"){
+            status();
+        }
+        else{
+            send("error unknown command " + command);
+        }
+        return true;
+    }
+
+    // Read commands until the client disconnects or quits
+    void run(){
+        std::string buffer;
+        char chunk[4096];
+        bool quit = false;
+        while(!quit){
+            ssize_t n = ::recv(socket, chunk, sizeof(chunk), 0);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) break;
+            buffer.append(chunk, static_cast<size_t>(n));
+            size_t newline;
+            while(!quit && (newline = buffer.find('\n')) != std::string::npos){
+                std::string line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if(!line.empty() && line.back() == '\r') line.pop_back();
+                quit = !handle(line);
+            }
+        }
+        // Sessions of the connection end with it
+        for(int id : ownSessions) pool.closeSession(id);
+        ownSessions.clear();
+    }
+};
+
+struct Client {
+    std::shared_ptr<Connection> connection;
+    std::thread thread;
+    std::shared_ptr<std::atomic<bool>> finished;
+};
+
+}
+
+int main(int argc, char* argv[]){
+    std::string socket_path = "astrado.sock";
+    int threads = 0;
+    long long memory_mb = 0;
+    std::string config_text;
+    std::string network_path;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--socket" && has_value) socket_path = argv[++i];
+        else if(arg == "--threads" && has_value) threads = std::atoi(argv[++i]);
+        else if(arg == "--memory" && has_value) memory_mb = std::atoll(argv[++i]);
+        else if(arg == "--config" && has_value) config_text = argv[++i];
+        else if(arg == "--network" && has_value) network_path = argv[++i];
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+
+    AstraDoNetwork::loadDefault(argv[0], network_path);
+    if(threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Same settings for every session, budgets come with each go
+    PlayerConfig config;
+    if(AstraDoNetwork::active()) config.mcts.rollout = RolloutType::Evaluation;
+    if(!PlayerConfig::parse(config_text, config)){
+        printUsage();
+        return 2;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(socket_path.size() >= sizeof(address.sun_path)){
+        std::fprintf(stderr, "socket path too long: %s\n", socket_path.c_str());
+        return 1;
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    // A socket file left by an earlier server would make bind fail
+    ::unlink(socket_path.c_str());
+    if(listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+       ::listen(listener, 64) != 0){
+        std::fprintf(stderr, "cannot listen on %s: %s\n", socket_path.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    // Without SA_RESTART a signal makes accept return, so the server can shut down cleanly
+    struct sigaction action{};
+    action.sa_handler = handleSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    std::fprintf(stderr, "listening on %s, %d threads, config %s\n", socket_path.c_str(), threads, config.toString().c_str());
+    {
+        SessionPool pool(threads, static_cast<size_t>(memory_mb) << 20, config.mcts, config.algorithm);
+        std::list<Client> clients;
+        while(!shutdownRequested){
+            int fd = ::accept(listener, nullptr, nullptr);
+            // Threads of closed connections are joined as new ones arrive
+            for(auto it = clients.begin(); it != clients.end();){
+                if(*it->finished){
+                    it->thread.join();
+                    it = clients.erase(it);
+                }
+                else ++it;
+            }
+            if(fd < 0) continue;
+            Client client;
+            client.connection = std::make_shared<Connection>(fd, pool);
+            client.connection->weakSelf = client.connection;
+            client.finished = std::make_shared<std::atomic<bool>>(false);
+            std::shared_ptr<Connection> connection = client.connection;
+            std::shared_ptr<std::atomic<bool>> finished = client.finished;
+            client.thread = std::thread([connection, finished]() {
+                connection->run();
+                *finished = true;
+            });
+            clients.push_back(std::move(client));
+        }
+        for(Client& client : clients) client.connection->interrupt();
+        for(Client& client : clients) client.thread.join();
+    }
+    ::close(listener);
+    ::unlink(socket_path.c_str());
+    return 0;
+}
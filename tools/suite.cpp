@@ -0,0 +1,204 @@
+#include "mcts.h"
+#include "nnue.h"
+#include "search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Test suite of positions with known best moves
+// Each line: <board> <side to move> <stale> bm <moves>; id "<name>"; further operations are ignored
+// Lines starting with # are comments
+namespace {
+
+void printUsage(){
+    std::fprintf(stderr,
+        "Usage: suite <file> [--iterations N] [--time MS] [--engine mcts|alphabeta] [--threads N] [--network FILE]\n"
+        "Positions are solved if the chosen move is one of the bm moves, the exit status is 1 unless all are\n");
+}
+
+struct SuiteEntry {
+    std::string id;
+    AstraDoBoard board;
+    std::vector<uint8_t> bestMoves;
+};
+
+struct SuiteResult {
+    uint8_t move = AstraDoGeometry::NO_MOVE;
+    bool solved = false;
+    // Time from which the search kept choosing a best move, -1 if it did not
+    double solvedMs = -1;
+    double ms = 0;
+    long long nodes = 0;
+};
+
+// How often MCTS is asked for its current move, to find the time to solution
+const int POLL_INTERVAL_MS = 5;
+
+std::string trim(const std::string& text){
+    size_t begin = text.find_first_not_of(" \t\r");
+    if(begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool parseEntry(const std::string& line, SuiteEntry& entry){
+    // Board is the first three fields
+    std::istringstream fields(line);
+    std::string squares, turn, stale;
+    if(!(fields >> squares >> turn >> stale)) return false;
+    if(!AstraDoBoard::fromString(squares + " " + turn + " " + stale, entry.board)) return false;
+    std::string rest;
+    std::getline(fields, rest);
+    std::istringstream operations(rest);
+    std::string operation;
+    while(std::getline(operations, operation, ';')){
+        std::istringstream tokens(trim(operation));
+        std::string name, token;
+        tokens >> name;
+        if(name == "bm"){
+            while(tokens >> token){
+                int move = token == "pass" ? AstraDoGeometry::PASS : std::atoi(token.c_str());
+                if(move < 0 || move > AstraDoGeometry::PASS) return false;
+                entry.bestMoves.push_back(static_cast<uint8_t>(move));
+            }
+        }
+        else if(name == "id"){
+            std::getline(tokens, token);
+            token = trim(token);
+            if(token.size() >= 2 && token.front() == '"' && token.back() == '"') token = token.substr(1, token.size() - 2);
+            entry.id = token;
+        }
+    }
+    return !entry.bestMoves.empty();
+}
+
+SuiteResult runEntry(const SuiteEntry& entry, SearchAlgorithm algorithm, const SearchBudget& budget){
+    SuiteResult result;
+    std::unique_ptr<SearchEngine> engine = createSearchEngine(algorithm, entry.board, budget);
+    auto is_best = [&entry](uint8_t move) {
+        return std::find(entry.bestMoves.begin(), entry.bestMoves.end(), move) != entry.bestMoves.end();
+    };
+    // MCTS reports its current choice while searching, other searchers only count if they end solved
+    if(MCTS* mcts = dynamic_cast<MCTS*>(engine.get())){
+        mcts->setSeed(1);
+        mcts->setInfoCallback([&result, &is_best](const MCTSInfo& info) {
+            bool best = info.bestVisits > 0 && is_best(info.bestMove);
+            if(!best) result.solvedMs = -1;
+            else if(result.solvedMs < 0) result.solvedMs = info.timeMs;
+        }, POLL_INTERVAL_MS);
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    result.move = engine->getBestMove();
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.nodes = engine->getNodeCount();
+    result.solved = is_best(result.move);
+    if(!result.solved) result.solvedMs = -1;
+    else if(result.solvedMs < 0 || result.solvedMs > result.ms) result.solvedMs = result.ms;
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2 || argv[1][0] == '-'){
+        printUsage();
+        return 2;
+    }
+    std::string suite_path = argv[1];
+    SearchBudget budget;
+    SearchAlgorithm algorithm = SearchAlgorithm::MCTS;
+    int threads = 0;
+    std::string network_path;
+    for(int i = 2; i < argc; ++i){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--iterations" && has_value) budget.nodes = std::atoll(argv[++i]);
+        else if(arg == "--time" && has_value) budget.timeMs = std::atoi(argv[++i]);
+        else if(arg == "--engine" && has_value){
+            if(!parseSearchAlgorithm(argv[++i], algorithm)){
+                printUsage();
+                return 2;
+            }
+        }
+        else if(arg == "--threads" && has_value) threads = std::atoi(argv[++i]);
+        else if(arg == "--network" && has_value) network_path = argv[++i];
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+    if(budget.nodes <= 0 && budget.timeMs <= 0) budget.timeMs = 1000;
+
+    std::ifstream in(suite_path);
+    if(!in){
+        std::fprintf(stderr, "cannot read %s\n", suite_path.c_str());
+        return 1;
+    }
+    std::vector<SuiteEntry> entries;
+    std::string line;
+    int line_number = 0;
+    while(std::getline(in, line)){
+        ++line_number;
+        line = trim(line);
+        if(line.empty() || line[0] == '#') continue;
+        SuiteEntry entry;
+        if(!parseEntry(line, entry)){
+            std::fprintf(stderr, "%s:%d: invalid entry\n", suite_path.c_str(), line_number);
+            return 1;
+        }
+        if(entry.id.empty()) entry.id = "line-" + std::to_string(line_number);
+        entries.push_back(entry);
+    }
+
+    AstraDoNetwork::loadDefault(argv[0], network_path);
+    if(threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<SuiteResult> results(entries.size());
+    std::atomic<size_t> next_entry{0};
+    auto worker = [&]() {
+        size_t index;
+        while((index = next_entry.fetch_add(1)) < entries.size()){
+            results[index] = runEntry(entries[index], algorithm, budget);
+        }
+    };
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for(int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for(std::thread& thread : pool) thread.join();
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int solved = 0;
+    double solve_ms = 0, total_ms = 0;
+    long long total_nodes = 0;
+    std::printf("%-16s %-6s %-6s %-10s %-10s %-10s %s\n", "id", "result", "move", "solved_ms", "nodes", "nps", "best");
+    for(size_t i = 0; i < entries.size(); ++i){
+        const SuiteEntry& entry = entries[i];
+        const SuiteResult& result = results[i];
+        std::string best;
+        for(uint8_t move : entry.bestMoves) best += (best.empty() ? "" : " ") + AstraDoBoard::moveToString(move);
+        char solved_ms[32] = "-";
+        if(result.solved) std::snprintf(solved_ms, sizeof(solved_ms), "%.0f", result.solvedMs);
+        std::printf("%-16s %-6s %-6s %-10s %-10lld %-10.0f %s\n", entry.id.c_str(), result.solved ? "ok" : "fail",
+                    AstraDoBoard::moveToString(result.move).c_str(), solved_ms, result.nodes,
+                    result.ms > 0 ? result.nodes * 1000 / result.ms : 0, best.c_str());
+        if(result.solved){
+            ++solved;
+            solve_ms += result.solvedMs;
+        }
+        total_ms += result.ms;
+        total_nodes += result.nodes;
+    }
+    std::printf("\nsolved %d / %zu (%.1f%%), mean time to solution %.0f ms, %.0f nodes per second per thread, %.1f s\n",
+                solved, entries.size(), entries.empty() ? 0 : 100.0 * solved / entries.size(),
+                solved > 0 ? solve_ms / solved : 0, total_ms > 0 ? total_nodes * 1000 / total_ms : 0, wall_seconds);
+    // Unsolved positions fail the run, so a suite can guard against regressions
+    return solved == static_cast<int>(entries.size()) ? 0 : 1;
+}
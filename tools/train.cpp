@@ -0,0 +1,386 @@
+#include "board.h"
+#include "nnue.h"
+#include "trainingdata.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// Trains the evaluation network on datagen shards and writes it in the format read by AstraDoNetwork::load
+// The target of a sample is the game result from the side to move: 1 for a win, 0.5 for a draw, 0 for a loss
+// Training is single-threaded, so the same shards and seed give the same file
+namespace {
+
+void printUsage(){
+    std::fprintf(stderr,
+        "Usage: train <shard>... --out FILE [--epochs N] [--batch N] [--rate R] [--validation F] [--seed N]\n"
+        "Shards are written by datagen, F is the fraction of samples held out to report the validation loss\n"
+        "Every sample is seen under a random one of the 12 symmetries of the board in every epoch\n");
+}
+
+const int INPUTS = 108;
+
+// Same scales as AstraDoNetwork: first layer 127, second layer 64, output 32
+const double FT_SCALE = 127;
+const double WEIGHT_SCALE = 64;
+const double OUTPUT_WEIGHT_SCALE = 32;
+// Quantized weights of the second and output layers are int8
+const double MAX_WEIGHT = 127 / WEIGHT_SCALE;
+const double MAX_OUTPUT_WEIGHT = 127 / OUTPUT_WEIGHT_SCALE;
+
+struct Sample {
+    uint64_t own = 0;
+    uint64_t oppo = 0;
+    float target = 0;
+};
+
+// Squares of every symmetry of the board, identity first
+// A symmetry maps the three directions onto each other and every direction reversed or not,
+// it is one if every cell is taken to a cell
+std::vector<std::array<uint8_t, 54>> boardSymmetries(){
+    const GeometryTables& tables = AstraDoGeometry::tables();
+    const int strips = AstraDoGeometry::LINES / 3;
+    std::vector<std::array<uint8_t, 54>> symmetries;
+    int permutations[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+    for(const int* permutation : permutations){
+        for(int reversed = 0; reversed < 8; ++reversed){
+            std::array<uint8_t, 54> symmetry;
+            bool valid = true;
+            for(int cell = 0; cell < 54 && valid; ++cell){
+                int image[3];
+                for(int direction = 0; direction < 3; ++direction){
+                    int strip = tables.squares[cell][direction][0] % strips;
+                    if(reversed >> direction & 1) strip = strips - 1 - strip;
+                    image[permutation[direction]] = strip;
+                }
+                int target = 0;
+                while(target < 54 && !(tables.squares[target][0][0] % strips == image[0] &&
+                                       tables.squares[target][1][0] % strips == image[1] &&
+                                       tables.squares[target][2][0] % strips == image[2])) ++target;
+                valid = target < 54;
+                symmetry[cell] = static_cast<uint8_t>(target);
+            }
+            if(valid) symmetries.push_back(symmetry);
+        }
+    }
+    return symmetries;
+}
+
+uint64_t mapSquares(uint64_t squares, const std::array<uint8_t, 54>& symmetry){
+    uint64_t mapped = 0;
+    for(; squares; squares &= squares - 1){
+        int square = 0;
+        while(!((squares >> square) & 1)) ++square;
+        mapped |= uint64_t(1) << symmetry[square];
+    }
+    return mapped;
+}
+
+// Float network with the layout of AstraDoNetwork
+struct Network {
+    std::vector<double> ftWeights = std::vector<double>(INPUTS * NNUE_HIDDEN);
+    std::vector<double> ftBias = std::vector<double>(NNUE_HIDDEN);
+    std::vector<double> l2Weights = std::vector<double>(NNUE_HIDDEN2 * 2 * NNUE_HIDDEN);
+    std::vector<double> l2Bias = std::vector<double>(NNUE_HIDDEN2);
+    std::vector<double> outWeights = std::vector<double>(NNUE_HIDDEN2);
+    std::vector<double> outBias = std::vector<double>(1);
+
+    std::vector<std::vector<double>*> parameters(){
+        return {&ftWeights, &ftBias, &l2Weights, &l2Bias, &outWeights, &outBias};
+    }
+};
+
+// Activations of one sample, kept for the backward pass
+struct Forward {
+    std::array<int, 54> features[2];
+    int featureCount[2];
+    std::array<double, 2 * NNUE_HIDDEN> accumulator;
+    std::array<double, 2 * NNUE_HIDDEN> input;
+    std::array<double, NNUE_HIDDEN2> hidden2;
+    std::array<double, NNUE_HIDDEN2> hidden;
+    double output;
+};
+
+double clip(double value, double low, double high){
+    return std::min(high, std::max(low, value));
+}
+
+// Log-odds of the side to move winning, own pieces are the side to move
+void forward(const Network& network, const Sample& sample, Forward& pass){
+    for(int half = 0; half < 2; ++half){
+        uint64_t first = half == 0 ? sample.own : sample.oppo;
+        uint64_t second = half == 0 ? sample.oppo : sample.own;
+        pass.featureCount[half] = 0;
+        for(int square = 0; square < 54; ++square){
+            if((first >> square) & 1) pass.features[half][pass.featureCount[half]++] = square;
+            else if((second >> square) & 1) pass.features[half][pass.featureCount[half]++] = 54 + square;
+        }
+        for(int i = 0; i < NNUE_HIDDEN; ++i){
+            double value = network.ftBias[i];
+            for(int f = 0; f < pass.featureCount[half]; ++f) value += network.ftWeights[pass.features[half][f] * NNUE_HIDDEN + i];
+            pass.accumulator[half * NNUE_HIDDEN + i] = value;
+            pass.input[half * NNUE_HIDDEN + i] = clip(value, 0, 1);
+        }
+    }
+    pass.output = network.outBias[0];
+    for(int j = 0; j < NNUE_HIDDEN2; ++j){
+        double value = network.l2Bias[j];
+        for(int i = 0; i < 2 * NNUE_HIDDEN; ++i) value += network.l2Weights[j * 2 * NNUE_HIDDEN + i] * pass.input[i];
+        pass.hidden2[j] = value;
+        pass.hidden[j] = clip(value, 0, 1);
+        pass.output += network.outWeights[j] * pass.hidden[j];
+    }
+}
+
+double sigmoid(double x){
+    return 1.0 / (1.0 + std::exp(-x));
+}
+
+double loss(double output, double target){
+    double p = clip(sigmoid(output), 1e-9, 1 - 1e-9);
+    return -(target * std::log(p) + (1 - target) * std::log(1 - p));
+}
+
+// Add the gradient of the cross-entropy loss of one sample
+void backward(const Network& network, const Forward& pass, double target, Network& gradient){
+    double d_output = sigmoid(pass.output) - target;
+    gradient.outBias[0] += d_output;
+    std::array<double, 2 * NNUE_HIDDEN> d_input{};
+    for(int j = 0; j < NNUE_HIDDEN2; ++j){
+        gradient.outWeights[j] += d_output * pass.hidden[j];
+        if(pass.hidden2[j] <= 0 || pass.hidden2[j] >= 1) continue;
+        double d_hidden = d_output * network.outWeights[j];
+        gradient.l2Bias[j] += d_hidden;
+        for(int i = 0; i < 2 * NNUE_HIDDEN; ++i){
+            gradient.l2Weights[j * 2 * NNUE_HIDDEN + i] += d_hidden * pass.input[i];
+            d_input[i] += d_hidden * network.l2Weights[j * 2 * NNUE_HIDDEN + i];
+        }
+    }
+    // Both perspectives share the first layer
+    for(int half = 0; half < 2; ++half){
+        for(int i = 0; i < NNUE_HIDDEN; ++i){
+            double value = pass.accumulator[half * NNUE_HIDDEN + i];
+            if(value <= 0 || value >= 1) continue;
+            double d_value = d_input[half * NNUE_HIDDEN + i];
+            gradient.ftBias[i] += d_value;
+            for(int f = 0; f < pass.featureCount[half]; ++f) gradient.ftWeights[pass.features[half][f] * NNUE_HIDDEN + i] += d_value;
+        }
+    }
+}
+
+// Adam, the int8 layers are kept inside the range they can be stored in
+class Optimizer {
+private:
+    Network first;
+    Network second;
+    long long steps = 0;
+    double rate;
+
+    static constexpr double BETA1 = 0.9;
+    static constexpr double BETA2 = 0.999;
+    static constexpr double EPSILON = 1e-8;
+
+public:
+    explicit Optimizer(double learning_rate) : rate(learning_rate) {
+        for(std::vector<double>* values : first.parameters()) std::fill(values->begin(), values->end(), 0.0);
+        for(std::vector<double>* values : second.parameters()) std::fill(values->begin(), values->end(), 0.0);
+    }
+
+    void step(Network& network, Network& gradient, int batch){
+        ++steps;
+        double correction1 = 1 - std::pow(BETA1, static_cast<double>(steps));
+        double correction2 = 1 - std::pow(BETA2, static_cast<double>(steps));
+        std::vector<std::vector<double>*> values = network.parameters();
+        std::vector<std::vector<double>*> gradients = gradient.parameters();
+        std::vector<std::vector<double>*> moments1 = first.parameters();
+        std::vector<std::vector<double>*> moments2 = second.parameters();
+        for(size_t p = 0; p < values.size(); ++p){
+            for(size_t i = 0; i < values[p]->size(); ++i){
+                double g = (*gradients[p])[i] / batch;
+                double& m = (*moments1[p])[i];
+                double& v = (*moments2[p])[i];
+                m = BETA1 * m + (1 - BETA1) * g;
+                v = BETA2 * v + (1 - BETA2) * g * g;
+                (*values[p])[i] -= rate * (m / correction1) / (std::sqrt(v / correction2) + EPSILON);
+                (*gradients[p])[i] = 0;
+            }
+        }
+        for(double& weight : network.l2Weights) weight = clip(weight, -MAX_WEIGHT, MAX_WEIGHT);
+        for(double& weight : network.outWeights) weight = clip(weight, -MAX_OUTPUT_WEIGHT, MAX_OUTPUT_WEIGHT);
+    }
+};
+
+template <typename T>
+bool writeValues(std::FILE* file, const T* data, size_t count){
+    return std::fwrite(data, sizeof(T), count, file) == count;
+}
+
+template <typename T>
+T quantize(double value, double scale){
+    double limit = static_cast<double>(std::numeric_limits<T>::max());
+    return static_cast<T>(clip(std::round(value * scale), -limit, limit));
+}
+
+// File layout of nnue.cpp
+bool save(const Network& network, const std::string& path){
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if(!file) return false;
+    uint32_t header[3] = {1, NNUE_HIDDEN, NNUE_HIDDEN2};
+    std::vector<int16_t> ft_weights, ft_bias;
+    std::vector<int8_t> l2_weights, out_weights;
+    std::vector<int32_t> l2_bias;
+    for(double weight : network.ftWeights) ft_weights.push_back(quantize<int16_t>(weight, FT_SCALE));
+    for(double bias : network.ftBias) ft_bias.push_back(quantize<int16_t>(bias, FT_SCALE));
+    for(double weight : network.l2Weights) l2_weights.push_back(quantize<int8_t>(weight, WEIGHT_SCALE));
+    for(double bias : network.l2Bias) l2_bias.push_back(quantize<int32_t>(bias, FT_SCALE * WEIGHT_SCALE));
+    for(double weight : network.outWeights) out_weights.push_back(quantize<int8_t>(weight, OUTPUT_WEIGHT_SCALE));
+    int32_t out_bias = quantize<int32_t>(network.outBias[0], FT_SCALE * OUTPUT_WEIGHT_SCALE);
+    bool ok = writeValues(file, "ADNN", 4) && writeValues(file, header, 3) &&
+              writeValues(file, ft_weights.data(), ft_weights.size()) &&
+              writeValues(file, ft_bias.data(), ft_bias.size()) &&
+              writeValues(file, l2_weights.data(), l2_weights.size()) &&
+              writeValues(file, l2_bias.data(), l2_bias.size()) &&
+              writeValues(file, out_weights.data(), out_weights.size()) &&
+              writeValues(file, &out_bias, 1);
+    return std::fclose(file) == 0 && ok;
+}
+
+double validationLoss(const Network& network, const std::vector<Sample>& samples){
+    double total = 0;
+    Forward pass;
+    for(const Sample& sample : samples){
+        forward(network, sample, pass);
+        total += loss(pass.output, sample.target);
+    }
+    return samples.empty() ? 0 : total / samples.size();
+}
+
+}
+
+int main(int argc, char* argv[]){
+    std::vector<std::string> shard_paths;
+    std::string out_path;
+    int epochs = 20;
+    int batch = 256;
+    double rate = 0.001;
+    double validation_fraction = 0.1;
+    uint32_t seed = 1;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--out" && has_value) out_path = argv[++i];
+        else if(arg == "--epochs" && has_value) epochs = std::atoi(argv[++i]);
+        else if(arg == "--batch" && has_value) batch = std::max(1, std::atoi(argv[++i]));
+        else if(arg == "--rate" && has_value) rate = std::atof(argv[++i]);
+        else if(arg == "--validation" && has_value) validation_fraction = std::atof(argv[++i]);
+        else if(arg == "--seed" && has_value) seed = static_cast<uint32_t>(std::atoll(argv[++i]));
+        else if(arg.compare(0, 2, "--") != 0) shard_paths.push_back(arg);
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+    if(shard_paths.empty() || out_path.empty()){
+        printUsage();
+        return 2;
+    }
+
+    // Positions from the side to move, the game result gives the target
+    std::vector<Sample> samples;
+    for(const std::string& path : shard_paths){
+        TrainingReader reader;
+        if(!reader.open(path)){
+            std::fprintf(stderr, "cannot read shard %s\n", path.c_str());
+            return 1;
+        }
+        for(uint64_t i = 0; i < reader.size(); ++i){
+            const PackedPosition& position = reader[i].position;
+            uint64_t black = position.black & PackedPosition::SQUARE_MASK;
+            uint64_t white = position.white & PackedPosition::SQUARE_MASK;
+            bool black_to_move = (position.white & PackedPosition::TURN_BIT) != 0;
+            Sample sample;
+            sample.own = black_to_move ? black : white;
+            sample.oppo = black_to_move ? white : black;
+            sample.target = reader[i].result > 0 ? 1.0f : reader[i].result < 0 ? 0.0f : 0.5f;
+            samples.push_back(sample);
+        }
+    }
+    std::mt19937 rng(seed);
+    std::shuffle(samples.begin(), samples.end(), rng);
+    size_t validation_count = static_cast<size_t>(samples.size() * clip(validation_fraction, 0, 0.5));
+    std::vector<Sample> validation(samples.end() - validation_count, samples.end());
+    samples.resize(samples.size() - validation_count);
+    if(samples.empty()){
+        std::fprintf(stderr, "no training samples\n");
+        return 1;
+    }
+    std::vector<std::array<uint8_t, 54>> symmetries = boardSymmetries();
+    std::fprintf(stderr, "%zu training samples, %zu validation samples, %zu symmetries\n",
+                 samples.size(), validation.size(), symmetries.size());
+
+    // Half of the first layer units start active, the rest of the network near zero
+    Network network;
+    std::normal_distribution<double> noise(0.0, 0.1);
+    for(double& weight : network.ftWeights) weight = noise(rng);
+    for(double& bias : network.ftBias) bias = 0.5;
+    for(double& weight : network.l2Weights) weight = noise(rng);
+    for(double& weight : network.outWeights) weight = noise(rng);
+
+    Network gradient;
+    for(std::vector<double>* values : gradient.parameters()) std::fill(values->begin(), values->end(), 0.0);
+    Optimizer optimizer(rate);
+    Forward pass;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int epoch = 1; epoch <= epochs; ++epoch){
+        std::shuffle(samples.begin(), samples.end(), rng);
+        double total = 0;
+        int in_batch = 0;
+        for(const Sample& sample : samples){
+            const std::array<uint8_t, 54>& symmetry = symmetries[rng() % symmetries.size()];
+            Sample seen = sample;
+            seen.own = mapSquares(sample.own, symmetry);
+            seen.oppo = mapSquares(sample.oppo, symmetry);
+            forward(network, seen, pass);
+            total += loss(pass.output, seen.target);
+            backward(network, pass, seen.target, gradient);
+            if(++in_batch == batch){
+                optimizer.step(network, gradient, in_batch);
+                in_batch = 0;
+            }
+        }
+        if(in_batch > 0) optimizer.step(network, gradient, in_batch);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::fprintf(stderr, "epoch %d train loss %.4f validation loss %.4f %.1f s\n",
+                     epoch, total / samples.size(), validationLoss(network, validation), seconds);
+    }
+
+    if(!save(network, out_path)){
+        std::fprintf(stderr, "cannot write %s\n", out_path.c_str());
+        return 1;
+    }
+    // The quantized network has to read back and agree with the float one
+    if(!AstraDoNetwork::load(out_path)){
+        std::fprintf(stderr, "cannot load %s\n", out_path.c_str());
+        return 1;
+    }
+    double largest_error = 0;
+    for(const Sample& sample : validation){
+        forward(network, sample, pass);
+        AstraDoBoard::Bits own_bits, oppo_bits;
+        own_bits.setWord(0, sample.own);
+        oppo_bits.setWord(0, sample.oppo);
+        AstraDoBoard board(own_bits, oppo_bits, true);
+        double quantized = AstraDoNetwork::active()->evaluate(board) / static_cast<double>(AstraDoNetwork::EVAL_SCALE);
+        largest_error = std::max(largest_error, std::fabs(sigmoid(quantized) - sigmoid(pass.output)));
+    }
+    std::fprintf(stderr, "wrote %s, largest win probability difference after quantization %.4f\n",
+                 out_path.c_str(), largest_error);
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "nnue.h"
+#include "selfplay.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// SPSA tuning of the MCTS exploration constant and expansion threshold
+// Every step plays a game pair between two configurations perturbed in opposite directions
+// and moves the parameters towards the side that scored better
+namespace {
+
+void printUsage(){
+    std::printf(
+        "Usage: tune [--steps N] [--threads N] [--base <config>] [--openings PLIES] [--seed N]\n"
+        "            [--c START] [--minvisits START] [--rate R] [--network FILE]\n"
+        "Base config sets the time control and fixed settings, e.g. iterations=500 or time=20,rollout=truncated\n"
+        "The base engine has to be mcts\n");
+}
+
+struct Parameter {
+    const char* name;
+    double value;
+    double min;
+    double max;
+    // Perturbation at the first step, decays to about half over a long run
+    double perturbation;
+};
+
+// Gain sequences as recommended by Spall, A is about a tenth of the expected number of steps
+const double ALPHA = 0.602;
+const double GAMMA = 0.101;
+
+}
+
+int main(int argc, char* argv[]){
+    std::vector<Parameter> parameters = {
+        {"c", MCTS::DEFAULT_C, 0.05, 10, 0.5},
+        {"minvisits", MCTS::DEFAULT_MIN_VISITS, 1, 50, 2},
+    };
+    PlayerConfig base;
+    base.budget.nodes = 500;
+    int steps = 1000;
+    int threads = 0;
+    int opening_plies = 4;
+    uint32_t seed = 1;
+    // Step size as a fraction of the perturbation, for a won game pair at the first step
+    double rate = 0.5;
+    std::string network_path;
+
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--steps" && has_value) steps = std::atoi(argv[++i]);
+        else if(arg == "--threads" && has_value) threads = std::atoi(argv[++i]);
+        else if(arg == "--base" && has_value){
+            // The tuned parameters only change MCTS games
+            if(!PlayerConfig::parse(argv[++i], base) || base.algorithm != SearchAlgorithm::MCTS){
+                printUsage();
+                return 2;
+            }
+        }
+        else if(arg == "--openings" && has_value) opening_plies = std::atoi(argv[++i]);
+        else if(arg == "--seed" && has_value) seed = static_cast<uint32_t>(std::atoll(argv[++i]));
+        else if(arg == "--c" && has_value) parameters[0].value = std::atof(argv[++i]);
+        else if(arg == "--minvisits" && has_value) parameters[1].value = std::atof(argv[++i]);
+        else if(arg == "--rate" && has_value) rate = std::atof(argv[++i]);
+        else if(arg == "--network" && has_value) network_path = argv[++i];
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+    // rollout=evaluation needs the network
+    AstraDoNetwork::loadDefault(argv[0], network_path);
+    if(threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const double stability = steps / 10.0;
+
+    std::printf("base: %s\n", base.toString().c_str());
+    std::mutex mutex;
+    std::atomic<int> next_step{0};
+    MatchScore total;
+
+    // Steps run asynchronously: a thread perturbs the parameters as they are when its step starts
+    auto worker = [&]() {
+        int k;
+        while((k = next_step.fetch_add(1)) < steps){
+            std::mt19937 rng(seed * 1000003u + static_cast<uint32_t>(k));
+            double ck = 1.0 / std::pow(k + 1, GAMMA);
+            double ak = std::pow(stability + 1, ALPHA) / std::pow(stability + k + 1, ALPHA);
+
+            PlayerConfig plus = base, minus = base;
+            std::vector<int> delta(parameters.size());
+            std::vector<double> shift(parameters.size());
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for(size_t i = 0; i < parameters.size(); ++i){
+                    delta[i] = rng() % 2 ? 1 : -1;
+                    shift[i] = ck * parameters[i].perturbation;
+                }
+                double c_plus = std::clamp(parameters[0].value + delta[0] * shift[0], parameters[0].min, parameters[0].max);
+                double c_minus = std::clamp(parameters[0].value - delta[0] * shift[0], parameters[0].min, parameters[0].max);
+                // Integer parameter, the rounding averages out over many steps
+                double visits_plus = std::clamp(parameters[1].value + delta[1] * shift[1], parameters[1].min, parameters[1].max);
+                double visits_minus = std::clamp(parameters[1].value - delta[1] * shift[1], parameters[1].min, parameters[1].max);
+                plus.mcts.c = c_plus;
+                minus.mcts.c = c_minus;
+                plus.mcts.minVisits = static_cast<int>(std::lround(visits_plus));
+                minus.mcts.minVisits = static_cast<int>(std::lround(visits_minus));
+            }
+
+            // Game pair from one opening, result is from the plus side: -2 to 2 games
+            AstraDoBoard opening = SelfPlay::randomOpening(opening_plies, rng);
+            MatchScore pair;
+            for(int plus_side = 0; plus_side < 2; ++plus_side){
+                GameRecord game = plus_side == 0
+                    ? SelfPlay::playGame(opening, plus, minus, rng())
+                    : SelfPlay::playGame(opening, minus, plus, rng());
+                int diff = game.blackPieces - game.whitePieces;
+                if(plus_side == 1) diff = -diff;
+                if(diff > 0) ++pair.wins;
+                else if(diff < 0) ++pair.losses;
+                else ++pair.draws;
+            }
+            int result = pair.wins - pair.losses;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            total.wins += pair.wins;
+            total.draws += pair.draws;
+            total.losses += pair.losses;
+            for(size_t i = 0; i < parameters.size(); ++i){
+                Parameter& parameter = parameters[i];
+                // Gradient estimate result / (2 shift delta), scaled so that the step is rate * shift
+                double step = rate * ak * parameter.perturbation * result * delta[i] / 2;
+                parameter.value = std::clamp(parameter.value + step, parameter.min, parameter.max);
+            }
+            int done = total.games() / 2;
+            if(done % 10 == 0 || done == steps){
+                std::printf("step %d:", done);
+                for(const Parameter& parameter : parameters) std::printf(" %s %.3f", parameter.name, parameter.value);
+                std::printf("  (perturbation");
+                for(double s : shift) std::printf(" %.3f", s);
+                std::printf(")\n");
+                std::fflush(stdout);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for(int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for(std::thread& thread : pool) thread.join();
+
+    std::printf("\nTuned for %s\n", base.toString().c_str());
+    std::printf("c=%.3f,minvisits=%ld\n", parameters[0].value, std::lround(parameters[1].value));
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include "trainingdata.h"
+
+TrainingWriter::~TrainingWriter(){
+    close();
+}
+
+void TrainingWriter::open(const std::string& shard_prefix, uint64_t samples_per_shard){
+    close();
+    prefix = shard_prefix;
+    samplesPerShard = samples_per_shard > 0 ? samples_per_shard : 1;
+    shardNumber = 0;
+    totalCount = 0;
+    failed = false;
+}
+
+bool TrainingWriter::openShard(){
+    return shard.open(prefix + "-" + std::to_string(shardNumber++) + ".adts");
+}
+
+bool TrainingWriter::write(const TrainingSample& sample){
+    if(failed || prefix.empty()) return false;
+    if(shard.isOpen() && shard.size() >= samplesPerShard) failed = !shard.close();
+    if(!failed && !shard.isOpen()) failed = !openShard();
+    if(failed || !shard.write(sample)){
+        failed = true;
+        return false;
+    }
+    ++totalCount;
+    return true;
+}
+
+bool TrainingWriter::close(){
+    if(shard.isOpen()) failed = !shard.close() || failed;
+    return !failed;
+}
+
+uint64_t TrainingWriter::size() const { return totalCount; }
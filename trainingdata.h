@@ -0,0 +1,60 @@
+#ifndef TRAININGDATA_H
+#define TRAININGDATA_H
+
+#include "positionfile.h"
+#include "recordfile.h"
+#include <cstdint>
+#include <string>
+
+// One position of a self-play game with its search and game outcome, 128 bytes
+struct TrainingSample {
+    PackedPosition position;
+    // Root visits of every square as a move of the side to move, capped at 65535
+    uint16_t visits[54];
+    // Final piece difference of the game, side to move minus opponent
+    int8_t result;
+    // Plies played since the start position of the game
+    uint8_t ply;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(TrainingSample) == 128, "training sample must have no padding");
+
+// Shards are record files of magic "ADTS" with one TrainingSample per sample
+inline constexpr RecordFormat TRAINING_SHARD_FORMAT = {{'A', 'D', 'T', 'S'}, 1};
+
+// Writes samples into numbered shard files, a new shard is started once one is full
+// Shards are named <prefix>-<number>.adts, the count in a header is written when the shard is closed
+class TrainingWriter {
+private:
+    std::string prefix;
+    uint64_t samplesPerShard = 0;
+    RecordWriter<TrainingSample, TRAINING_SHARD_FORMAT> shard;
+    int shardNumber = 0;
+    uint64_t totalCount = 0;
+    bool failed = false;
+
+    bool openShard();
+
+public:
+    TrainingWriter() = default;
+    ~TrainingWriter();
+
+    TrainingWriter(const TrainingWriter&) = delete;
+    TrainingWriter& operator=(const TrainingWriter&) = delete;
+
+    // Shards are created on the first write
+    void open(const std::string& shard_prefix, uint64_t samples_per_shard);
+
+    bool write(const TrainingSample& sample);
+
+    // Close the last shard, returns false if any write failed
+    bool close();
+
+    uint64_t size() const;
+};
+
+// Memory-mapped shard, samples are read in place
+using TrainingReader = RecordReader<TrainingSample, TRAINING_SHARD_FORMAT>;
+
+#endif // TRAININGDATA_H
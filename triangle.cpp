@@ -1,4 +1,6 @@
 #include "triangle.h"
+#include <algorithm>
+#include <cmath>
 
 Triangle::Triangle(int id, bool direction, QGraphicsItem* parent)
     : t_id(id), t_direction(direction), status(TriangleStatus::EMPTY), QGraphicsObject(parent) {
@@ -24,6 +26,12 @@ void Triangle::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidge
     painter->setBrush(t_color);
     painter->setPen(Qt::NoPen);
     painter->drawPolygon(triangle);
+
+    // Candidate moves of a running search, stronger colour for more visits
+    if(heatLevel >= 0){
+        painter->setBrush(QColor(220, 20, 60, 40 + 180 * heatLevel / HEAT_LEVELS));
+        painter->drawPolygon(triangle);
+    }
 }
 
 // Define precise shape (triangle) for mouse detection
@@ -51,6 +59,20 @@ void Triangle::changeStatus(TriangleStatus status) {
     update();
 }
 
+bool Triangle::setStatus(TriangleStatus status) {
+    if(this->status == status) return false;
+    this->status = status;
+    updateColor();
+    return true;
+}
+
+bool Triangle::setHeat(double heat) {
+    int level = heat < 0 ? -1 : std::lround(std::min(heat, 1.0) * HEAT_LEVELS);
+    if(level == heatLevel) return false;
+    heatLevel = level;
+    return true;
+}
+
 void Triangle::changeColor(QColor color) {
     t_color = color;
     update();
@@ -80,7 +102,6 @@ void Triangle::updateColor() {
         t_color = QColorConstants::Svg::brown;
         break;
     }
-    update();
 }
 
 // Handle mouse clicks
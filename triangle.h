@@ -27,8 +27,14 @@ public:
 
     int getID() const;
     void changeStatus(TriangleStatus state);
+    // Change the status without repainting, returns whether it changed
+    // The caller repaints all changed triangles at once
+    bool setStatus(TriangleStatus state);
     void changeColor(QColor color);
     void updateColor();
+    // Search heatmap overlay, from 0 to 1, negative to hide it
+    // Does not repaint, returns whether the shown overlay changed
+    bool setHeat(double heat);
 
 signals:
     void clicked(int id);  // Custom click signal
@@ -44,6 +50,8 @@ protected:
 public:
     const static int TRIANGLE_LENGTH = 64;
     const static int TRIANGLE_HEIGHT = 0.866 * TRIANGLE_LENGTH;
+    // Distinct overlay shades, small changes of the heat are not repainted
+    const static int HEAT_LEVELS = 16;
 
 
 
@@ -52,6 +60,8 @@ private:
     bool t_direction;
     TriangleStatus status;
     QColor t_color;
+    // Overlay shade from 0 to HEAT_LEVELS, -1 if hidden
+    int heatLevel = -1;
 };
 
 